@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <mpi.h>
+#include "mvm_matrix.h"
+
+/*
+ * Matrix-vector product y = A x with a 2D block distribution of A, next to the 1D distribution by rows:
+ * + 1d: process p owns a block of rows of A, and every product needs the whole x (MPI_Bcast of n values
+ *   to every process), which does not scale with the number of processes.
+ * + 2d: the processes form a grid of prows x pcols (MPI_Dims_create), process (i,j) owns the block of
+ *   rows i and columns j of A. The communicators of the process rows and columns are made with
+ *   MPI_Comm_split. The block j of x, held by the process (0,j), is broadcast along the process column j,
+ *   each process multiplies its block, and the partial blocks of y are summed along the process row i
+ *   on the process (i,0) with MPI_Reduce: each process only moves n/pcols + n/prows values.
+ * Each process generates its own blocks of A. The product is repeated -i times, then y is gathered
+ * on process 0 to check it. The values moved per product by each process (x received, y sent)
+ * are reported for both distributions: the root of a broadcast receives nothing and the root of a
+ * reduction sends nothing, so with one process column (pcols = 1) the reduction moves no value.
+ */
+
+/* the distributions */
+typedef enum{
+	DISTRIBUTION_1D = 0,
+	DISTRIBUTION_2D,
+	DISTRIBUTIONS
+} mvm_layout;
+
+static const char* layoutNames[DISTRIBUTIONS] = {"1d", "2d"};
+
+/* result of a distribution */
+typedef struct{
+	double time;		/* time of the products, max over the processes */
+	double bytes;		/* bytes moved by a process per product, max over the processes */
+	double error;		/* largest relative error of y */
+} mvm_result;
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int myid, int* n, mvm_type* type, int* iterations);
+/* products with the distribution by rows, y gathered on process 0 */
+void multiply1D(mvm_type type, int n, int iterations, mvm_result* result);
+/* products with the 2D block distribution, y gathered on process 0 */
+void multiply2D(mvm_type type, int n, int iterations, mvm_result* result);
+
+/*
+ * to compile:
+ * mpicc -o mvm2D mvm2D.c mvm_matrix.c -lm
+ * to run, 10 products of a 4096 x 4096 matrix of doubles on 16 processes (4 x 4):
+ * mpirun -np 16 ./mvm2D -n 4096 -t double -i 10
+ */
+int main(int argc, char* argv[]){
+
+	MPI_Init(&argc, &argv);
+	int myid, numprocs, layout;
+	int n = 1024;
+	int iterations = 1;
+	int dims[2] = {0, 0};
+	mvm_type type = MVM_INT;
+	mvm_result results[DISTRIBUTIONS];
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+	parseArgs(argc, argv, myid, &n, &type, &iterations);
+
+	multiply1D(type, n, iterations, &results[DISTRIBUTION_1D]);
+	multiply2D(type, n, iterations, &results[DISTRIBUTION_2D]);
+	if(myid == 0){
+		MPI_Dims_create(numprocs, 2, dims);
+		printf("matrix %d x %d of %s, %d processes, 2d grid %d x %d\n", n, n, mvm_type_name(type), numprocs, dims[0], dims[1]);
+		printf("layout\titerations\ttime/product (us)\tbytes/process/product\terror\n");
+		for(layout=0;layout<DISTRIBUTIONS;++layout){
+			printf("%s\t%d\t\t%f\t\t%.0f\t\t\t%g\n", layoutNames[layout], iterations,
+				1e6*results[layout].time/iterations, results[layout].bytes, results[layout].error);
+		}
+	}
+	MPI_Finalize();
+	return 0;
+}
+
+void multiply1D(mvm_type type, int n, int iterations, mvm_result* result){
+	int myid, numprocs, myRows, myFirst, k;
+	int *counts, *displs;
+	size_t size = mvm_type_size(type);
+	MPI_Datatype elementType = mvm_type_mpi(type);
+	void *myA, *x, *myY, *y = NULL;
+	double time, bytes, maxBytes;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+	counts = (int*) malloc(sizeof(int)*numprocs);
+	displs = (int*) malloc(sizeof(int)*numprocs);
+	mvm_partition(n, numprocs, counts, displs);
+	mvm_partition_rank(n, numprocs, myid, &myRows, &myFirst);
+	myA = mvm_alloc(type, (size_t)myRows*n);
+	x = mvm_alloc(type, n);
+	myY = mvm_alloc(type, myRows);
+	mvm_fill_matrix(type, myA, myFirst, myRows, n);
+	if(myid == 0){
+		y = mvm_alloc(type, n);
+		mvm_fill_vector(type, x, n);
+	}
+
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = MPI_Wtime();
+	for(k=0;k<iterations;++k){
+		MPI_Bcast(x, n, elementType, 0, MPI_COMM_WORLD);
+		mvm_multiply(type, myA, x, myY, myRows, n);
+	}
+	time = MPI_Wtime()-time;
+	MPI_Reduce(&time, &result->time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	/*
+	 * the whole x is received by every process but the root
+	 */
+	bytes = myid != 0 ? (double) size*n : 0.0;
+	MPI_Reduce(&bytes, &maxBytes, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	result->bytes = maxBytes;
+
+	MPI_Gatherv(myY, myRows, elementType, y, counts, displs, elementType, 0, MPI_COMM_WORLD);
+	if(myid == 0){
+		result->error = mvm_check(type, y, n);
+	}
+	free(myA);
+	free(x);
+	free(myY);
+	free(y);
+	free(counts);
+	free(displs);
+}
+
+void multiply2D(mvm_type type, int n, int iterations, mvm_result* result){
+	int myid, numprocs, k;
+	int dims[2] = {0, 0};
+	int myRow, myCol, myRows, myFirst, myCols, myFirstCol;
+	int *counts, *displs;
+	size_t size = mvm_type_size(type);
+	MPI_Datatype elementType = mvm_type_mpi(type);
+	MPI_Comm rowComm, colComm;
+	void *myA, *x, *myPartialY, *myY, *y = NULL;
+	double time, bytes, maxBytes;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+	MPI_Dims_create(numprocs, 2, dims);
+	myRow = myid/dims[1];
+	myCol = myid%dims[1];
+	/*
+	 * the processes of a row are ordered by column and the processes of a column by row:
+	 * the process (i,0) is the rank 0 of the row i, the process (0,j) the rank 0 of the column j
+	 */
+	MPI_Comm_split(MPI_COMM_WORLD, myRow, myCol, &rowComm);
+	MPI_Comm_split(MPI_COMM_WORLD, myCol, myRow, &colComm);
+	mvm_partition_rank(n, dims[0], myRow, &myRows, &myFirst);
+	mvm_partition_rank(n, dims[1], myCol, &myCols, &myFirstCol);
+
+	myA = mvm_alloc(type, (size_t)myRows*myCols);
+	x = mvm_alloc(type, n);
+	myPartialY = mvm_alloc(type, myRows);
+	myY = mvm_alloc(type, myRows);
+	mvm_fill_block(type, myA, myFirst, myRows, myFirstCol, myCols, n);
+	if(myRow == 0){
+		mvm_fill_vector(type, x, n);
+	}
+
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = MPI_Wtime();
+	for(k=0;k<iterations;++k){
+		/*
+		 * the block j of x along the process column j
+		 */
+		MPI_Bcast((char*) x+size*myFirstCol, myCols, elementType, 0, colComm);
+		mvm_multiply(type, myA, (char*) x+size*myFirstCol, myPartialY, myRows, myCols);
+		/*
+		 * the sum of the partial blocks of y along the process row i
+		 */
+		MPI_Reduce(myPartialY, myY, myRows, elementType, MPI_SUM, 0, rowComm);
+	}
+	time = MPI_Wtime()-time;
+	MPI_Reduce(&time, &result->time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	/*
+	 * a block of x received, except by the root of the process column (myRow = 0),
+	 * and a partial block of y sent, except by the root of the process row (myCol = 0)
+	 */
+	bytes = (double) size*((myRow != 0 ? myCols : 0)+(myCol != 0 ? myRows : 0));
+	MPI_Reduce(&bytes, &maxBytes, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	result->bytes = maxBytes;
+
+	/*
+	 * the blocks of y are on the process column 0, gathered on process (0,0)
+	 */
+	if(myCol == 0){
+		counts = (int*) malloc(sizeof(int)*dims[0]);
+		displs = (int*) malloc(sizeof(int)*dims[0]);
+		mvm_partition(n, dims[0], counts, displs);
+		if(myRow == 0) y = mvm_alloc(type, n);
+		MPI_Gatherv(myY, myRows, elementType, y, counts, displs, elementType, 0, colComm);
+		if(myRow == 0){
+			result->error = mvm_check(type, y, n);
+		}
+		free(counts);
+		free(displs);
+	}
+	MPI_Comm_free(&rowComm);
+	MPI_Comm_free(&colComm);
+	free(myA);
+	free(x);
+	free(myPartialY);
+	free(myY);
+	free(y);
+}
+
+void parseArgs(int argc, char** argv, int myid, int* n, mvm_type* type, int* iterations){
+	int c, t;
+	while((c=getopt(argc, argv, "n:t:i:")) != -1){
+		switch(c){
+			case 'n':
+				*n = atoi(optarg);
+				break;
+			case 't':
+				t = mvm_type_parse(optarg);
+				if(t < 0){
+					if(myid == 0) printf("unknown type %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				*type = (mvm_type) t;
+				break;
+			case 'i':
+				*iterations = atoi(optarg);
+				break;
+			default:
+				if(myid == 0) printf("usage: %s [-n size] [-t int|float|double] [-i iterations]\n", argv[0]);
+				MPI_Finalize();
+				exit(1);
+		}
+	}
+	if(*n < 1 || *iterations < 1){
+		if(myid == 0) printf("the size and the iterations must be positive\n");
+		MPI_Finalize();
+		exit(1);
+	}
+}
@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <mpi.h>
+#include "mvm_matrix.h"
+
+/*
+ * Matrix-vector product y = A x for a matrix of any size, distributed by rows:
+ * unlike mvm.c (SIZE fixed, matrix on the stack, MPI_Scatter of SIZE/numprocs rows),
+ * the size and the element type are given on the command line, the matrices are on the heap,
+ * and the rows are split with MPI_Scatterv/MPI_Gatherv so every row is computed
+ * whatever the number of processes (the first n%numprocs processes own one more row).
+ * A row is sent as one element of a contiguous datatype, so the counts do not overflow
+ * for large matrices.
+ *
+ * with -i iterations, the same A is multiplied many times (power iteration):
+ * A is distributed once, and each iteration only moves the vector: every process owns
+ * the rows of its block of y, which is the same block of the next x, and the blocks are
+ * all-gathered on all the processes.
+ * + allgatherv: MPI_Allgatherv, then the product
+ * + iallgatherv: MPI_Iallgatherv, and while the blocks are exchanged, the product of the
+ *   diagonal block of A (the columns of the own block of x, known before the exchange),
+ *   then the other columns after MPI_Wait
+ * for float and double, the product is divided by the largest value of x (the estimate of
+ * the largest eigenvalue is the largest value of y); for int, x = y % 3 to avoid the overflow.
+ */
+
+/* the exchanges of the vector */
+typedef enum{
+	GATHER_BLOCKING = 0,
+	GATHER_NONBLOCKING,
+	GATHER_MODES
+} gather_mode;
+
+static const char* gatherNames[GATHER_MODES] = {"allgatherv", "iallgatherv"};
+
+/* the distributed matrix and vectors of a process */
+typedef struct{
+	mvm_type type;
+	int n;
+	int myRows, myFirst;
+	int *counts, *displs;	/* rows of all the processes */
+	void* myA;		/* myRows x n */
+	void* x;		/* the whole vector */
+	void* myX;		/* the own block of x */
+	void* myY;		/* the own block of y */
+} mvm_distribution;
+
+/* result of the repeated products */
+typedef struct{
+	double time;		/* max over the processes */
+	double gatherTime;	/* max over the processes of the time in the exchange or waiting for it */
+	double value;		/* largest eigenvalue estimate (float, double) or sum of y (int) */
+} mvm_result;
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int myid, int* n, mvm_type* type, int* iterations, int* gatherMode,
+	int* isCheck, int* isDisplay);
+/* prints the vector */
+void printVector(mvm_type type, const void* v, int n);
+/*
+ * iterations products y = A x / max|x|, the blocks of y are gathered in x after each product,
+ * x starts from x0
+ */
+void repeat(mvm_distribution* m, const void* x0, int iterations, gather_mode mode, mvm_result* result);
+
+/*
+ * to compile:
+ * mpicc -o mvm_distributed mvm_distributed.c mvm_matrix.c -lm
+ * to run, a 5000 x 5000 matrix of doubles on 3 processes, with the check of the result:
+ * mpirun -np 3 ./mvm_distributed -n 5000 -t double -c
+ * 100 products of the same matrix, with the 2 exchanges of the vector:
+ * mpirun -np 4 ./mvm_distributed -n 4096 -t double -i 100
+ */
+int main(int argc, char* argv[]){
+
+	MPI_Init(&argc, &argv);
+	int myid, numprocs;
+	int n = 1024;
+	mvm_type type = MVM_INT;
+	int iterations = 0;
+	int selectedMode = -1;	/* -1: all the exchanges */
+	int isCheck = 0, isDisplay = 0;
+	int mode;
+	mvm_distribution m;
+	mvm_result result;
+	void *A = NULL, *x0, *y = NULL;
+	MPI_Datatype rowType, elementType;
+	double time, times[3], maxTimes[3];
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+	parseArgs(argc, argv, myid, &n, &type, &iterations, &selectedMode, &isCheck, &isDisplay);
+	elementType = mvm_type_mpi(type);
+
+	m.type = type;
+	m.n = n;
+	m.counts = (int*) malloc(sizeof(int)*numprocs);
+	m.displs = (int*) malloc(sizeof(int)*numprocs);
+	mvm_partition(n, numprocs, m.counts, m.displs);
+	mvm_partition_rank(n, numprocs, myid, &m.myRows, &m.myFirst);
+
+	/* init matrix A and vector x */
+	m.x = mvm_alloc(type, n);
+	if(myid == 0){
+		A = mvm_alloc(type, (size_t)n*n);
+		y = mvm_alloc(type, n);
+		mvm_fill_matrix(type, A, 0, n, n);
+		mvm_fill_vector(type, m.x, n);
+	}
+	m.myA = mvm_alloc(type, (size_t)m.myRows*n);
+	m.myX = mvm_alloc(type, m.myRows);
+	m.myY = mvm_alloc(type, m.myRows);
+	MPI_Type_contiguous(n, elementType, &rowType);
+	MPI_Type_commit(&rowType);
+
+	/*
+	 * distribute data: the counts and displacements are in rows
+	 */
+	MPI_Barrier(MPI_COMM_WORLD);
+	time = MPI_Wtime();
+	MPI_Bcast(m.x, n, elementType, 0, MPI_COMM_WORLD);
+	MPI_Scatterv(A, m.counts, m.displs, rowType, m.myA, m.myRows, rowType, 0, MPI_COMM_WORLD);
+	times[0] = MPI_Wtime()-time;
+
+	if(iterations > 0){
+		/*
+		 * A stays on the processes, only the vector moves
+		 */
+		x0 = mvm_alloc(type, n);
+		memcpy(x0, m.x, mvm_type_size(type)*n);
+		MPI_Reduce(times, maxTimes, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+		if(myid == 0){
+			printf("matrix %d x %d of %s, %d processes, %d to %d rows per process, scatter %f (s)\n",
+				n, n, mvm_type_name(type), numprocs, m.counts[numprocs-1], m.counts[0], maxTimes[0]);
+			printf("exchange\titerations\ttime/iteration (us)\texchange/iteration (us)\tGFLOP/s\t\t%s\n",
+				type == MVM_INT ? "sum of y" : "eigenvalue");
+		}
+		for(mode=0;mode<GATHER_MODES;++mode){
+			if(selectedMode >= 0 && mode != selectedMode) continue;
+			repeat(&m, x0, iterations, (gather_mode) mode, &result);
+			if(myid == 0){
+				printf("%-12s\t%d\t\t%f\t\t%f\t\t%f\t%.6f\n", gatherNames[mode], iterations,
+					1e6*result.time/iterations, 1e6*result.gatherTime/iterations,
+					2.0*n*(double)n*iterations/result.time/1e9, result.value);
+			}
+		}
+		free(x0);
+	}else{
+		/*
+		 * calculate local values
+		 */
+		time = MPI_Wtime();
+		mvm_multiply(type, m.myA, m.x, m.myY, m.myRows, n);
+		times[1] = MPI_Wtime()-time;
+
+		/*
+		 * collect data: the counts and displacements in rows are also the ones of y
+		 */
+		time = MPI_Wtime();
+		MPI_Gatherv(m.myY, m.myRows, elementType, y, m.counts, m.displs, elementType, 0, MPI_COMM_WORLD);
+		times[2] = MPI_Wtime()-time;
+
+		MPI_Reduce(times, maxTimes, 3, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+		if(myid == 0){
+			printf("matrix %d x %d of %s, %d processes, %d to %d rows per process\n",
+				n, n, mvm_type_name(type), numprocs, m.counts[numprocs-1], m.counts[0]);
+			printf("scatter (s)\tcompute (s)\tgather (s)\n");
+			printf("%f\t%f\t%f\n", maxTimes[0], maxTimes[1], maxTimes[2]);
+			if(isCheck){
+				printf("largest relative error %g\n", mvm_check(type, y, n));
+			}
+			/* print result vector */
+			if(isDisplay){
+				printVector(type, y, n);
+			}
+		}
+	}
+
+	MPI_Type_free(&rowType);
+	free(A);
+	free(y);
+	free(m.x);
+	free(m.myA);
+	free(m.myX);
+	free(m.myY);
+	free(m.counts);
+	free(m.displs);
+	MPI_Finalize();
+	return 0;
+}
+
+void repeat(mvm_distribution* m, const void* x0, int iterations, gather_mode mode, mvm_result* result){
+	int i, k;
+	int n = m->n, myRows = m->myRows, myFirst = m->myFirst;
+	size_t size = mvm_type_size(m->type);
+	double startTime, time, gatherTime = 0.0, scale, local[2], global[2];
+	MPI_Datatype elementType = mvm_type_mpi(m->type);
+	MPI_Request request;
+
+	memcpy(m->myX, (const char*) x0+size*myFirst, size*myRows);
+	MPI_Barrier(MPI_COMM_WORLD);
+	startTime = MPI_Wtime();
+	for(k=0;k<iterations;++k){
+		if(mode == GATHER_BLOCKING){
+			time = MPI_Wtime();
+			MPI_Allgatherv(m->myX, myRows, elementType, m->x, m->counts, m->displs, elementType, MPI_COMM_WORLD);
+			gatherTime += MPI_Wtime()-time;
+			mvm_multiply(m->type, m->myA, m->x, m->myY, myRows, n);
+		}else{
+			time = MPI_Wtime();
+			MPI_Iallgatherv(m->myX, myRows, elementType, m->x, m->counts, m->displs, elementType, MPI_COMM_WORLD,
+				&request);
+			gatherTime += MPI_Wtime()-time;
+			/*
+			 * the diagonal block with the own block of x, x is not read before the end of the exchange
+			 */
+			mvm_multiply_columns(m->type, m->myA, m->myX, m->myY, myRows, n, myFirst, myRows, 0);
+			time = MPI_Wtime();
+			MPI_Wait(&request, MPI_STATUS_IGNORE);
+			gatherTime += MPI_Wtime()-time;
+			mvm_multiply_columns(m->type, m->myA, m->x, m->myY, myRows, n, 0, myFirst, 1);
+			mvm_multiply_columns(m->type, m->myA, (const char*) m->x+size*(myFirst+myRows), m->myY, myRows, n,
+				myFirst+myRows, n-myFirst-myRows, 1);
+		}
+		/*
+		 * next x: every process has the whole x, so its largest value needs no reduction
+		 */
+		if(m->type == MVM_INT){
+			for(i=0;i<myRows;++i){
+				((int*) m->myX)[i] = ((int*) m->myY)[i] % 3;
+			}
+		}else{
+			scale = mvm_max_abs(m->type, m->x, n);
+			mvm_scale(m->type, m->myY, myRows, scale > 0.0 ? 1.0/scale : 1.0);
+			memcpy(m->myX, m->myY, size*myRows);
+		}
+	}
+	time = MPI_Wtime()-startTime;
+
+	local[0] = time;
+	local[1] = gatherTime;
+	MPI_Reduce(local, global, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	result->time = global[0];
+	result->gatherTime = global[1];
+	if(m->type == MVM_INT){
+		local[0] = 0.0;
+		for(i=0;i<myRows;++i) local[0] += ((int*) m->myY)[i];
+		MPI_Reduce(local, &result->value, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+	}else{
+		local[0] = mvm_max_abs(m->type, m->myY, myRows);
+		MPI_Reduce(local, &result->value, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	}
+}
+
+void printVector(mvm_type type, const void* v, int n){
+	int i;
+	for(i=0;i<n;++i){
+		printf("%g ", mvm_get(type, v, i));
+	}
+	printf("\n");
+}
+
+void parseArgs(int argc, char** argv, int myid, int* n, mvm_type* type, int* iterations, int* gatherMode,
+	int* isCheck, int* isDisplay){
+	int c, t;
+	while((c=getopt(argc, argv, "n:t:i:g:cd")) != -1){
+		switch(c){
+			case 'n':
+				*n = atoi(optarg);
+				break;
+			case 't':
+				t = mvm_type_parse(optarg);
+				if(t < 0){
+					if(myid == 0) printf("unknown type %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				*type = (mvm_type) t;
+				break;
+			case 'i':
+				*iterations = atoi(optarg);
+				break;
+			case 'g':
+				if(strcmp(optarg, "all") == 0){
+					*gatherMode = -1;
+					break;
+				}
+				for(t=0;t<GATHER_MODES;++t){
+					if(strcmp(optarg, gatherNames[t]) == 0) *gatherMode = t;
+				}
+				if(*gatherMode < 0){
+					if(myid == 0) printf("unknown exchange %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				break;
+			case 'c':
+				*isCheck = 1;
+				break;
+			case 'd':
+				*isDisplay = 1;
+				break;
+			default:
+				if(myid == 0) printf("usage: %s [-n size] [-t int|float|double] [-i iterations] [-g allgatherv|iallgatherv|all] [-c] [-d]\n", argv[0]);
+				MPI_Finalize();
+				exit(1);
+		}
+	}
+	if(*n < 1 || *iterations < 0){
+		if(myid == 0) printf("the size must be positive, the iterations not negative\n");
+		MPI_Finalize();
+		exit(1);
+	}
+	/*
+	 * the repeated products are scaled at each iteration, there is no single product to check or display
+	 */
+	if(*iterations > 0 && (*isCheck || *isDisplay)){
+		if(myid == 0) printf("-c and -d are only for a single product, not with -i\n");
+		MPI_Finalize();
+		exit(1);
+	}
+}
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+#include "mvm_matrix.h"
+
+static const char* typeNames[MVM_TYPES] = {"int", "float", "double"};
+
+const char* mvm_type_name(mvm_type type){
+	return typeNames[type];
+}
+
+int mvm_type_parse(const char* name){
+	int t;
+	for(t=0;t<MVM_TYPES;++t){
+		if(strcmp(name, typeNames[t]) == 0) return t;
+	}
+	return -1;
+}
+
+size_t mvm_type_size(mvm_type type){
+	switch(type){
+		case MVM_INT: return sizeof(int);
+		case MVM_FLOAT: return sizeof(float);
+		default: return sizeof(double);
+	}
+}
+
+MPI_Datatype mvm_type_mpi(mvm_type type){
+	switch(type){
+		case MVM_INT: return MPI_INT;
+		case MVM_FLOAT: return MPI_FLOAT;
+		default: return MPI_DOUBLE;
+	}
+}
+
+void mvm_partition(int n, int numprocs, int* counts, int* displs){
+	int p;
+	for(p=0;p<numprocs;++p){
+		mvm_partition_rank(n, numprocs, p, &counts[p], &displs[p]);
+	}
+}
+
+void mvm_partition_rank(int n, int numprocs, int p, int* count, int* first){
+	int block = n/numprocs, remainder = n%numprocs;
+	*count = block + (p < remainder ? 1 : 0);
+	*first = p*block + (p < remainder ? p : remainder);
+}
+
+void* mvm_alloc(mvm_type type, size_t count){
+	void* v = malloc(mvm_type_size(type)*(count > 0 ? count : 1));
+	if(v == NULL){
+		printf("cannot allocate %lu elements\n", (unsigned long) count);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	return v;
+}
+
+/*
+ * the same code for each element type
+ */
+#define FILL_BLOCK(T) \
+	{ \
+		T* a = (T*) A; \
+		for(i=0;i<rows;++i){ \
+			for(j=0;j<cols;++j){ \
+				a[(size_t)i*cols+j] = (T) ((((long long)(first+i))*n+firstCol+j) % 3); \
+			} \
+		} \
+	}
+
+void mvm_fill_matrix(mvm_type type, void* A, int first, int rows, int cols){
+	mvm_fill_block(type, A, first, rows, 0, cols, cols);
+}
+
+void mvm_fill_block(mvm_type type, void* A, int first, int rows, int firstCol, int cols, int n){
+	int i, j;
+	switch(type){
+		case MVM_INT: FILL_BLOCK(int) break;
+		case MVM_FLOAT: FILL_BLOCK(float) break;
+		default: FILL_BLOCK(double) break;
+	}
+}
+
+#define FILL_VECTOR(T) \
+	{ \
+		T* v = (T*) x; \
+		for(i=0;i<n;++i){ \
+			v[i] = (T) ((n-i) % 3); \
+		} \
+	}
+
+void mvm_fill_vector(mvm_type type, void* x, int n){
+	int i;
+	switch(type){
+		case MVM_INT: FILL_VECTOR(int) break;
+		case MVM_FLOAT: FILL_VECTOR(float) break;
+		default: FILL_VECTOR(double) break;
+	}
+}
+
+#define MULTIPLY(T) \
+	{ \
+		const T* a = (const T*) A; \
+		const T* v = (const T*) x; \
+		T* result = (T*) y; \
+		for(i=0;i<rows;++i){ \
+			const T* row = a+(size_t)i*cols; \
+			T sum = 0; \
+			for(j=0;j<cols;++j){ \
+				sum += row[j]*v[j]; \
+			} \
+			result[i] = sum; \
+		} \
+	}
+
+void mvm_multiply(mvm_type type, const void* A, const void* x, void* y, int rows, int cols){
+	int i, j;
+	switch(type){
+		case MVM_INT: MULTIPLY(int) break;
+		case MVM_FLOAT: MULTIPLY(float) break;
+		default: MULTIPLY(double) break;
+	}
+}
+
+#define MULTIPLY_COLUMNS(T) \
+	{ \
+		const T* a = (const T*) A; \
+		const T* v = (const T*) x; \
+		T* result = (T*) y; \
+		for(i=0;i<rows;++i){ \
+			const T* row = a+(size_t)i*cols; \
+			T sum = accumulate ? result[i] : 0; \
+			for(j=first;j<first+count;++j){ \
+				sum += row[j]*v[j-first]; \
+			} \
+			result[i] = sum; \
+		} \
+	}
+
+void mvm_multiply_columns(mvm_type type, const void* A, const void* x, void* y, int rows, int cols,
+	int first, int count, int accumulate){
+	int i, j;
+	switch(type){
+		case MVM_INT: MULTIPLY_COLUMNS(int) break;
+		case MVM_FLOAT: MULTIPLY_COLUMNS(float) break;
+		default: MULTIPLY_COLUMNS(double) break;
+	}
+}
+
+double mvm_max_abs(mvm_type type, const void* v, int n){
+	int i;
+	double value, max = 0.0;
+	for(i=0;i<n;++i){
+		value = fabs(mvm_get(type, v, i));
+		if(value > max) max = value;
+	}
+	return max;
+}
+
+void mvm_scale(mvm_type type, void* v, int n, double factor){
+	int i;
+	if(type == MVM_FLOAT){
+		for(i=0;i<n;++i) ((float*) v)[i] *= (float) factor;
+	}else if(type == MVM_DOUBLE){
+		for(i=0;i<n;++i) ((double*) v)[i] *= factor;
+	}
+}
+
+double mvm_get(mvm_type type, const void* v, size_t i){
+	switch(type){
+		case MVM_INT: return ((const int*) v)[i];
+		case MVM_FLOAT: return ((const float*) v)[i];
+		default: return ((const double*) v)[i];
+	}
+}
+
+double mvm_check(mvm_type type, const void* y, int n){
+	int i, j;
+	double error, maxError = 0.0;
+	for(i=0;i<n;++i){
+		double expected = 0.0;
+		for(j=0;j<n;++j){
+			expected += (double) ((((long long) i)*n+j) % 3) * ((n-j) % 3);
+		}
+		error = fabs(mvm_get(type, y, i)-expected)/(expected > 1.0 ? expected : 1.0);
+		if(error > maxError) maxError = error;
+	}
+	return maxError;
+}
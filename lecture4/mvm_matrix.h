@@ -0,0 +1,74 @@
+#ifndef MVM_MATRIX_H
+#define MVM_MATRIX_H
+#include <stddef.h>
+#include <mpi.h>
+
+/*
+ * Dense matrices of any size for the distributed matrix-vector products:
+ * the element type is chosen at run time (int, float or double), the matrices are
+ * stored row after row on the heap, and the rows are split among the processes
+ * with the remainder spread over the first processes (block sizes differ by at most 1).
+ */
+
+/* the element types */
+typedef enum{
+	MVM_INT = 0,
+	MVM_FLOAT,
+	MVM_DOUBLE,
+	MVM_TYPES
+} mvm_type;
+
+/* name of a type, for the arguments and the output */
+const char* mvm_type_name(mvm_type type);
+/* type of a name, -1 if the name is unknown */
+int mvm_type_parse(const char* name);
+/* size in bytes of an element */
+size_t mvm_type_size(mvm_type type);
+/* MPI datatype of an element */
+MPI_Datatype mvm_type_mpi(mvm_type type);
+
+/*
+ * balanced split of n items among numprocs processes:
+ * process p owns counts[p] items starting at displs[p], the first n%numprocs processes own one more
+ */
+void mvm_partition(int n, int numprocs, int* counts, int* displs);
+/* the items of process p only */
+void mvm_partition_rank(int n, int numprocs, int p, int* count, int* first);
+
+/* allocates count elements (aborts if the memory is missing) */
+void* mvm_alloc(mvm_type type, size_t count);
+/*
+ * fills rows first..first+rows-1 of the n x cols matrix A[i][j] = (i*cols+j) % 3,
+ * A points to the first of these rows
+ */
+void mvm_fill_matrix(mvm_type type, void* A, int first, int rows, int cols);
+/*
+ * fills the block of rows first..first+rows-1 and columns firstCol..firstCol+cols-1 of the same
+ * matrix of n columns, stored as a rows x cols matrix
+ */
+void mvm_fill_block(mvm_type type, void* A, int first, int rows, int firstCol, int cols, int n);
+/* fills the vector x[i] = (n-i) % 3 of size n */
+void mvm_fill_vector(mvm_type type, void* x, int n);
+/*
+ * y = A x for the rows x cols matrix A
+ */
+void mvm_multiply(mvm_type type, const void* A, const void* x, void* y, int rows, int cols);
+/*
+ * y += A[:, first..first+count-1] x, the product of a block of columns:
+ * x holds the count values of these columns, y is set to 0 first if accumulate is 0
+ */
+void mvm_multiply_columns(mvm_type type, const void* A, const void* x, void* y, int rows, int cols,
+	int first, int count, int accumulate);
+/* largest absolute value of a vector */
+double mvm_max_abs(mvm_type type, const void* v, int n);
+/* v = v*factor, for the floating point types only */
+void mvm_scale(mvm_type type, void* v, int n, double factor);
+/* element i of a vector as a double */
+double mvm_get(mvm_type type, const void* v, size_t i);
+/*
+ * checks y = A x for the matrix and the vector of mvm_fill_matrix/mvm_fill_vector,
+ * computed in double precision; returns the largest relative error
+ */
+double mvm_check(mvm_type type, const void* y, int n);
+
+#endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <mpi.h>
+#include "mpi_profile.h"
 
 #define SIZE 16
 #define THRESHOLD 0.001 
@@ -65,6 +66,11 @@ int main(int argc, char* argv[]){
 	}
 	
 	int convergence = 1;
+	/*
+	 * time of the computation of each process, over all the iterations
+	 */
+	int iterations = 0;
+	double time, computeTime = 0.0, maxComputeTime;
 	
 	while(convergence){
 		
@@ -120,6 +126,7 @@ int main(int argc, char* argv[]){
 			rows = block;
 		}
 		float diffnorm = 0.0;
+		time = MPI_Wtime();
 		/*
 		 * calculating values and convergence
 		 */
@@ -130,20 +137,21 @@ int main(int argc, char* argv[]){
 			}	
 		}
 		
-		diffnorm = sqrt(diffnorm);
 		for(i=1;i<rows;++i){
 			for(j=1;j<SIZE-1;++j){
 				myJacobi[i][j] = myNewJacobi[i][j];
 			}	
 		}
+		computeTime += MPI_Wtime()-time;
 		/* 
-		 * checking for convergence  
+		 * checking for convergence: the squared differences are summed over all the processes,
+		 * the square root is taken on the global sum  
 		 */
 		float diffnormReduce;
 		MPI_Reduce(&diffnorm, &diffnormReduce, 1, MPI_FLOAT, MPI_SUM, 0, MPI_COMM_WORLD);
 
 		if(myid == 0){
-			if(diffnormReduce < THRESHOLD){
+			if(sqrt(diffnormReduce) < THRESHOLD){
 				convergence = 0;
 				MPI_Bcast(&convergence, 1, MPI_INT,0,MPI_COMM_WORLD);
 			}else{
@@ -153,8 +161,10 @@ int main(int argc, char* argv[]){
 		}else{
 			MPI_Bcast(&convergence, 1, MPI_INT, 0, MPI_COMM_WORLD);
 		}
-	
+		++iterations;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
 	}
+	MPI_Reduce(&computeTime, &maxComputeTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 	/*
 	 * gather output for sauce
 	 */
@@ -165,6 +175,7 @@ int main(int argc, char* argv[]){
 	}
 	if(myid == 0){
 		printMatrix(jacobi, SIZE);
+		printf("%d iterations, compute/iteration %f (us), max over the processes\n", iterations, 1e6*maxComputeTime/iterations);
 	}
 
 	MPI_Finalize();
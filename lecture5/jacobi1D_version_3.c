@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <mpi.h>
+#include "mpi_profile.h"
 
 #define SIZE 16
 #define THRESHOLD 0.001 
@@ -64,6 +65,11 @@ int main(int argc, char* argv[]){
 	}
 	
 	int convergence = 1;
+	/*
+	 * time of the computation of each process, over all the iterations
+	 */
+	int iterations = 0;
+	double time, computeTime = 0.0, maxComputeTime;
 	
 	while(convergence){
 		
@@ -113,6 +119,7 @@ int main(int argc, char* argv[]){
 			rows = block;
 		}
 		float diffnorm = 0.0;
+		time = MPI_Wtime();
 		/*
 		 * calculating independent values and convergence
 		 */
@@ -122,6 +129,7 @@ int main(int argc, char* argv[]){
 				diffnorm += (myNewJacobi[i][j] - myJacobi[i][j])*(myNewJacobi[i][j] - myJacobi[i][j]);
 			}	
 		}
+		computeTime += MPI_Wtime()-time;
 		/*
 		 * waiting for first row
 		 */
@@ -132,11 +140,13 @@ int main(int argc, char* argv[]){
 			MPI_Wait(&recv_request[0], &status);
 		}
 		
+		time = MPI_Wtime();
 		i=1;
 		for(j=1;j<SIZE-1;++j){
 			myNewJacobi[i][j] = (myJacobi[i-1][j]+myJacobi[i+1][j]+myJacobi[i][j-1]+myJacobi[i][j+1])/4.0;
 			diffnorm += (myNewJacobi[i][j] - myJacobi[i][j])*(myNewJacobi[i][j] - myJacobi[i][j]);
 		}	
+		computeTime += MPI_Wtime()-time;
 		/*
 		 * waiting for last row
 		 */
@@ -147,26 +157,28 @@ int main(int argc, char* argv[]){
 			MPI_Wait(&recv_request[1], &status);
 		}
 
+		time = MPI_Wtime();
 		i=rows-1;
 		for(j=1;j<SIZE-1;++j){
 			myNewJacobi[i][j] = (myJacobi[i-1][j]+myJacobi[i+1][j]+myJacobi[i][j-1]+myJacobi[i][j+1])/4.0;
 			diffnorm += (myNewJacobi[i][j] - myJacobi[i][j])*(myNewJacobi[i][j] - myJacobi[i][j]);
 		}
 
-		diffnorm = sqrt(diffnorm);
 		for(i=1;i<rows;++i){
 			for(j=1;j<SIZE-1;++j){
 				myJacobi[i][j] = myNewJacobi[i][j];
 			}	
 		}
+		computeTime += MPI_Wtime()-time;
 		/* 
-		 * checking for convergence  
+		 * checking for convergence: the squared differences are summed over all the processes,
+		 * the square root is taken on the global sum  
 		 */
 		float diffnormReduce;
 		MPI_Reduce(&diffnorm, &diffnormReduce, 1, MPI_FLOAT, MPI_SUM, 0, MPI_COMM_WORLD);
 
 		if(myid == 0){
-			if(diffnormReduce < THRESHOLD){
+			if(sqrt(diffnormReduce) < THRESHOLD){
 				convergence = 0;
 				MPI_Bcast(&convergence, 1, MPI_INT,0,MPI_COMM_WORLD);
 			}else{
@@ -176,8 +188,10 @@ int main(int argc, char* argv[]){
 		}else{
 			MPI_Bcast(&convergence, 1, MPI_INT, 0, MPI_COMM_WORLD);
 		}
-	
+		++iterations;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
 	}
+	MPI_Reduce(&computeTime, &maxComputeTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 	/*
 	 * gather output for sauce
 	 */
@@ -188,6 +202,7 @@ int main(int argc, char* argv[]){
 	}
 	if(myid == 0){
 		printMatrix(jacobi, SIZE);
+		printf("%d iterations, compute/iteration %f (us), max over the processes\n", iterations, 1e6*maxComputeTime/iterations);
 	}
 	MPI_Finalize();
 	return 0;
@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <getopt.h>
+#include <mpi.h>
+#include <omp.h>
+#include "jacobi_domain.h"
+#include "jacobi_kernel.h"
+#include "jacobi_convergence.h"
+#include "jacobi_io.h"
+#include "mpi_profile.h"
+
+#define THRESHOLD 0.001
+#define MAX_ITERATIONS 1000000
+
+/*
+ * Jacobi iteration on a grid of runtime size, distributed by rows,
+ * with a choice of halo exchange (see jacobi_domain.h):
+ * blocking (version 1), ordered (version 2), non-blocking (version 3),
+ * persistent requests and neighbor collective.
+ * For each mode, the time spent in the exchange is measured per iteration.
+ *
+ * the rows which do not need the ghost rows (2..localRows-1) are computed
+ * between halo_start() and halo_finish(), as in version 3.
+ * the convergence is checked every checkInterval sweeps, with a reduction
+ * overlapped with the next sweep (see jacobi_convergence.h)
+ *
+ * with a deep halo (-h depth), depth ghost rows are exchanged at once
+ * and depth sweeps are done without communication, as a wavefront (see jacobi_kernel.h):
+ * depth times less messages, and the grid is read once from memory for depth sweeps.
+ * the ghost rows are computed redundantly by the neighbors.
+ *
+ * hybrid MPI+OpenMP (-t threads, e.g. one process per socket): the master thread
+ * does the exchange while the other threads update the inner rows (see jacobi_kernel.h)
+ *
+ * the grid can also be solved with red-black Gauss-Seidel or SOR (-m):
+ * the red points ((i+j) even) only depend on the black points and the other way round,
+ * so each color is updated in place in parallel, with one halo exchange per color.
+ */
+
+/* the iterative methods */
+typedef enum{
+	METHOD_JACOBI = 0,
+	METHOD_GAUSS_SEIDEL,
+	METHOD_SOR,
+	METHODS
+} jacobi_method;
+
+static const char* methodNames[METHODS] = {"jacobi", "gs", "sor"};
+
+/* result of a run with one method and one halo mode */
+typedef struct{
+	int iterations;
+	double time;		/* time to solution */
+	double exchangeTime;	/* max over the processes of the time spent in the exchange */
+	double computeTime;	/* max over the processes of the time spent in the sweeps */
+	int checks;		/* number of global reductions */
+} jacobi_result;
+
+/*
+ * solve with one halo mode, checking the convergence every checkInterval exchanges,
+ * with depth sweeps per exchange
+ */
+void solve(jacobi_domain* d, int checkInterval, int threads, jacobi_result* result);
+/*
+ * solve with red-black Gauss-Seidel (omega = 1) or SOR, one halo exchange per color,
+ * checking the convergence every checkInterval iterations (both colors)
+ */
+void solveRedBlack(jacobi_domain* d, float omega, int checkInterval, jacobi_result* result);
+/*
+ * optimal SOR parameter for the Laplace equation on a rows x cols grid:
+ * 2/(1+sqrt(1-rho^2)), with rho the spectral radius of the Jacobi iteration
+ */
+float optimalOmega(int rows, int cols);
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int myid, int* rows, int* cols, char** inputName, char** outputName, int* mode, int* method,
+	float* omega, int* checkInterval, int* depth, int* threads, int* isDisplay);
+
+/*
+ * to compile:
+ * mpicc -fopenmp -o jacobi1D_version_4 jacobi1D_version_4.c jacobi_domain.c jacobi_kernel.c jacobi_convergence.c jacobi_io.c jacobi_text.c -lm
+ * to run, compare all the halo modes on a 2048 x 2048 grid:
+ * mpirun -np 8 ./jacobi1D_version_4 -r 2048 -c 2048
+ * only the persistent requests, on the input file:
+ * mpirun -np 4 ./jacobi1D_version_4 -i jacobiInput.txt -x persistent -d
+ * checking the convergence every 10 sweeps:
+ * mpirun -np 8 ./jacobi1D_version_4 -r 2048 -c 2048 -k 10
+ * 8 sweeps per exchange:
+ * mpirun -np 8 ./jacobi1D_version_4 -r 2048 -c 2048 -h 8
+ * 2 processes of 4 threads:
+ * mpirun -np 2 ./jacobi1D_version_4 -r 2048 -c 2048 -t 4
+ * compare Jacobi, Gauss-Seidel and SOR with the persistent exchange:
+ * mpirun -np 4 ./jacobi1D_version_4 -r 512 -c 512 -x persistent -m all
+ * binary input and output with MPI-IO (the size is read from the file):
+ * mpirun -np 4 ./jacobi1D_version_4 -i jacobiInput.bin -o result.bin -x persistent
+ */
+int main(int argc, char* argv[]){
+
+	int provided;
+	/*
+	 * the threads do not call MPI, only the master thread does (MPI_THREAD_FUNNELED)
+	 */
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+	jacobi_domain d;
+	jacobi_result result;
+	int rows = 16, cols = 16;
+	char* inputName = NULL;
+	char* outputName = NULL;
+	int selectedMode = -1;		/* -1: all the modes */
+	int selectedMethod = METHOD_JACOBI;	/* -1: all the methods */
+	float omega = 0.0;		/* 0: optimal value */
+	int isDisplay = 0;
+	int checkInterval = 1;
+	int depth = 1;
+	int threads = 1;
+	int myid, numprocs, mode, method;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+	parseArgs(argc, argv, myid, &rows, &cols, &inputName, &outputName, &selectedMode, &selectedMethod,
+		&omega, &checkInterval, &depth, &threads, &isDisplay);
+	/*
+	 * the size of a binary grid is given by its header
+	 */
+	if(inputName != NULL && jacobi_io_is_binary(inputName)){
+		if(!jacobi_io_read_size(MPI_COMM_WORLD, inputName, &rows, &cols)){
+			MPI_Finalize();
+			return 1;
+		}
+	}
+	if(omega == 0.0){
+		omega = optimalOmega(rows, cols);
+	}
+	if(threads > 1 && provided < MPI_THREAD_FUNNELED){
+		if(myid == 0) printf("The MPI library does not support MPI_THREAD_FUNNELED\n");
+		MPI_Finalize();
+		return 1;
+	}
+	omp_set_num_threads(threads);
+	if(myid == 0){
+		printf("grid %d x %d, %d processes of %d threads, %d sweeps per exchange, convergence checked every %d exchanges\n",
+			rows, cols, numprocs, threads, depth, checkInterval);
+		if(selectedMethod < 0 || selectedMethod == METHOD_SOR) printf("SOR parameter %f\n", omega);
+		printf("method\tmode\t\titerations\ttime (s)\texchange/iteration (us)\tcompute/iteration (us)\treductions\n");
+	}
+	for(method=0;method<METHODS;++method){
+		if(selectedMethod >= 0 && method != selectedMethod) continue;
+		for(mode=0;mode<HALO_MODES;++mode){
+			if(selectedMode >= 0 && mode != selectedMode) continue;
+			/*
+			 * Gauss-Seidel and SOR need the new values of the neighbors: one ghost row
+			 */
+			if(!jacobi_domain_create(&d, MPI_COMM_WORLD, rows, cols, method == METHOD_JACOBI ? depth : 1, mode)){
+				if(myid == 0) printf("Too many processes for %d rows with %d ghost rows\n", rows, depth);
+				MPI_Finalize();
+				return 1;
+			}
+			if(inputName != NULL && jacobi_io_is_binary(inputName)){
+				if(!jacobi_domain_read(&d, inputName)) MPI_Abort(MPI_COMM_WORLD, 1);
+			}else if(inputName != NULL){
+				if(!jacobi_domain_read_text(&d, inputName)) MPI_Abort(MPI_COMM_WORLD, 1);
+			}else{
+				jacobi_domain_generate(&d);
+			}
+			if(method == METHOD_JACOBI){
+				solve(&d, checkInterval, threads, &result);
+			}else{
+				solveRedBlack(&d, method == METHOD_SOR ? omega : 1.0, checkInterval, &result);
+			}
+			if(myid == 0){
+				printf("%s\t%-12s\t%d\t\t%lf\t%lf\t\t%lf\t\t%d\n", methodNames[method], halo_mode_name(mode),
+					result.iterations, result.time, 1e6*result.exchangeTime/result.iterations,
+					1e6*result.computeTime/result.iterations, result.checks);
+			}
+			if(isDisplay){
+				jacobi_domain_print(&d);
+			}
+			if(outputName != NULL){
+				jacobi_domain_write(&d, outputName);
+			}
+			jacobi_domain_free(&d);
+		}
+	}
+	MPI_Finalize();
+	return 0;
+}
+
+void solve(jacobi_domain* d, int checkInterval, int threads, jacobi_result* result){
+	int n = d->localRows;
+	int iterations = 0, exchanges = 0;
+	float diffnorm;
+	double startTime, time, localTimes[2], maxTimes[2];
+	double exchangeTime = 0.0, computeTime = 0.0;
+	jacobi_convergence convergenceCheck;
+
+	convergence_init(&convergenceCheck, d->comm, THRESHOLD, checkInterval);
+	MPI_Barrier(d->comm);
+	startTime = MPI_Wtime();
+	int convergence = 1;
+	while(convergence && iterations < MAX_ITERATIONS){
+		if(threads > 1){
+			/*
+			 * the exchange time is the time of the master thread, overlapped with the other threads
+			 */
+			time = MPI_Wtime();
+			diffnorm = jacobi_hybrid_sweep(d, &exchangeTime);
+			computeTime += MPI_Wtime()-time;
+		}else if(d->depth == 1){
+			time = MPI_Wtime();
+			halo_start(d);
+			exchangeTime += MPI_Wtime()-time;
+			/*
+			 * calculating independent values
+			 */
+			time = MPI_Wtime();
+			diffnorm = jacobi_sweep_rows(d, 2, n-1);
+			computeTime += MPI_Wtime()-time;
+			/*
+			 * waiting for the ghost rows
+			 */
+			time = MPI_Wtime();
+			halo_finish(d);
+			exchangeTime += MPI_Wtime()-time;
+			/*
+			 * first and last rows
+			 */
+			time = MPI_Wtime();
+			diffnorm += jacobi_sweep_rows(d, 1, 1);
+			if(n > 1) diffnorm += jacobi_sweep_rows(d, n, n);
+			computeTime += MPI_Wtime()-time;
+			jacobi_swap(d);
+		}else{
+			/*
+			 * deep halo: all the rows depend on the ghost rows after the first sweep
+			 */
+			time = MPI_Wtime();
+			halo_start(d);
+			halo_finish(d);
+			exchangeTime += MPI_Wtime()-time;
+			time = MPI_Wtime();
+			diffnorm = jacobi_wavefront(d, d->depth);
+			computeTime += MPI_Wtime()-time;
+		}
+		iterations += d->depth;
+		/*
+		 * checking for convergence: norm of the difference of the last sweep on the whole grid
+		 */
+		if(convergence_update(&convergenceCheck, exchanges, diffnorm)){
+			convergence = 0;
+		}
+		++exchanges;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
+	}
+	convergence_free(&convergenceCheck);
+	result->time = MPI_Wtime()-startTime;
+	result->iterations = iterations;
+	result->checks = convergenceCheck.checks;
+	localTimes[0] = exchangeTime;
+	localTimes[1] = computeTime;
+	MPI_Allreduce(localTimes, maxTimes, 2, MPI_DOUBLE, MPI_MAX, d->comm);
+	result->exchangeTime = maxTimes[0];
+	result->computeTime = maxTimes[1];
+}
+
+void solveRedBlack(jacobi_domain* d, float omega, int checkInterval, jacobi_result* result){
+	int n = d->localRows;
+	int iterations = 0, color;
+	float diffnorm;
+	double startTime, time, localTimes[2], maxTimes[2];
+	double exchangeTime = 0.0, computeTime = 0.0;
+	jacobi_convergence convergenceCheck;
+
+	convergence_init(&convergenceCheck, d->comm, THRESHOLD, checkInterval);
+	MPI_Barrier(d->comm);
+	startTime = MPI_Wtime();
+	int convergence = 1;
+	while(convergence && iterations < MAX_ITERATIONS){
+		diffnorm = 0.0;
+		for(color=0;color<2;++color){
+			/*
+			 * the ghost rows hold the values of the other color updated by the neighbors
+			 */
+			time = MPI_Wtime();
+			halo_start(d);
+			exchangeTime += MPI_Wtime()-time;
+			time = MPI_Wtime();
+			diffnorm += jacobi_color_sweep_rows(d, 2, n-1, color, omega);
+			computeTime += MPI_Wtime()-time;
+			time = MPI_Wtime();
+			halo_finish(d);
+			exchangeTime += MPI_Wtime()-time;
+			time = MPI_Wtime();
+			diffnorm += jacobi_color_sweep_rows(d, 1, 1, color, omega);
+			if(n > 1) diffnorm += jacobi_color_sweep_rows(d, n, n, color, omega);
+			computeTime += MPI_Wtime()-time;
+		}
+		/*
+		 * checking for convergence: norm of the difference on the whole grid
+		 */
+		if(convergence_update(&convergenceCheck, iterations, diffnorm)){
+			convergence = 0;
+		}
+		++iterations;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
+	}
+	convergence_free(&convergenceCheck);
+	result->time = MPI_Wtime()-startTime;
+	result->iterations = iterations;
+	result->checks = convergenceCheck.checks;
+	localTimes[0] = exchangeTime;
+	localTimes[1] = computeTime;
+	MPI_Allreduce(localTimes, maxTimes, 2, MPI_DOUBLE, MPI_MAX, d->comm);
+	result->exchangeTime = maxTimes[0];
+	result->computeTime = maxTimes[1];
+}
+
+float optimalOmega(int rows, int cols){
+	double rho = (cos(M_PI/(rows-1)) + cos(M_PI/(cols-1)))/2.0;
+	return 2.0/(1.0+sqrt(1.0-rho*rho));
+}
+
+void parseArgs(int argc, char** argv, int myid, int* rows, int* cols, char** inputName, char** outputName, int* mode, int* method,
+	float* omega, int* checkInterval, int* depth, int* threads, int* isDisplay){
+	int c;
+	while((c=getopt(argc, argv, "r:c:i:o:x:m:w:k:h:t:d")) != -1){
+		switch(c){
+			case 'r':
+				*rows = atoi(optarg);
+				break;
+			case 'c':
+				*cols = atoi(optarg);
+				break;
+			case 'i':
+				*inputName = optarg;
+				break;
+			case 'o':
+				*outputName = optarg;
+				break;
+			case 'x':
+				*mode = halo_mode_parse(optarg);
+				if(*mode < 0 && strcmp(optarg, "all") != 0){
+					if(myid == 0) printf("Unknown halo mode %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				break;
+			case 'm':
+				for(*method=METHODS-1;*method>=0;--*method){
+					if(strcmp(optarg, methodNames[*method]) == 0) break;
+				}
+				if(*method < 0 && strcmp(optarg, "all") != 0){
+					if(myid == 0) printf("Unknown method %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				break;
+			case 'w':
+				*omega = atof(optarg);
+				break;
+			case 'k':
+				*checkInterval = atoi(optarg);
+				break;
+			case 'h':
+				*depth = atoi(optarg);
+				break;
+			case 't':
+				*threads = atoi(optarg);
+				break;
+			case 'd':
+				*isDisplay = 1;
+				break;
+			default:
+				if(myid == 0) printf("usage: %s [-r rows] [-c cols] [-i input] [-o output.bin] [-x blocking|ordered|nonblocking|persistent|neighbor|all] [-m jacobi|gs|sor|all] [-w omega] [-k check_interval] [-h depth] [-t threads] [-d]\n", argv[0]);
+				MPI_Finalize();
+				exit(1);
+		}
+	}
+	if(*rows < 3 || *cols < 3 || *checkInterval < 1 || *depth < 1){
+		if(myid == 0) printf("The grid must have at least 3 rows and 3 columns, the check interval and the depth must be positive\n");
+		MPI_Finalize();
+		exit(1);
+	}
+	if(*omega < 0.0 || *omega >= 2.0){
+		if(myid == 0) printf("The SOR parameter must be between 0 and 2\n");
+		MPI_Finalize();
+		exit(1);
+	}
+	if(*threads < 1 || (*threads > 1 && *depth > 1)){
+		if(myid == 0) printf("The number of threads must be positive, and the threads are used with a halo of depth 1\n");
+		MPI_Finalize();
+		exit(1);
+	}
+}
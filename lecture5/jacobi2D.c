@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <getopt.h>
+#include <mpi.h>
+#include "jacobi_convergence.h"
+#include "jacobi_io.h"
+#include "jacobi_text.h"
+#include "mpi_profile.h"
+
+#define THRESHOLD 0.001
+#define MAX_ITERATIONS 1000000
+/*
+ * tag of the rows sent between process 0 and the owners: the messages between 2 processes
+ * arrive in the order they are sent, which is the order of the rows
+ * (a row index could be above the largest tag guaranteed by MPI, 32767)
+ */
+#define ROW_TAG 37
+
+/*
+ * Jacobi iteration on a grid of runtime size,
+ * with a 2D domain decomposition:
+ * the processes are arranged in a dims[0] x dims[1] cartesian grid (MPI_Cart_create),
+ * each process owns a block of rows and columns, surrounded by one ghost cell.
+ * Per iteration 4 halo exchanges are performed (up, down, left, right),
+ * the columns are sent with a strided derived datatype (MPI_Type_vector).
+ * Compared with the row decomposition of jacobi1D_version_*.c, the halo of a block
+ * of n*n cells on p processes is 4*n/sqrt(p) instead of 2*n cells.
+ */
+typedef struct{
+	int rows, cols;			/* global grid size */
+	MPI_Comm cart;			/* cartesian communicator */
+	int myid, numprocs;
+	int dims[2], coords[2];
+	int up, down, left, right;	/* neighbors, MPI_PROC_NULL at the border */
+	int firstRow, firstCol;		/* global index of the first owned row/column */
+	int localRows, localCols;	/* size of the owned block */
+	float* grid;			/* (localRows+2) x (localCols+2), with ghost cells */
+	float* newGrid;
+	MPI_Datatype column;		/* one column of the owned block */
+} grid2D;
+
+/* element (i,j) of a local block, ghost cells have index 0 and localRows+1 / localCols+1 */
+#define AT(g,grid,i,j) (grid)[(long)(i)*((g)->localCols+2)+(j)]
+
+/*
+ * balanced block distribution of n elements among parts,
+ * the first n%parts parts get one more element
+ */
+void partition(int n, int parts, int index, int* first, int* count);
+/*
+ * create the cartesian grid of processes and allocate the local block
+ */
+void createGrid(grid2D* g, int rows, int cols);
+void freeGrid(grid2D* g);
+/*
+ * initial values:
+ * read from a text file by process 0 (one row at a time, sent to the owners),
+ * or generated by each process (same values as jacobiInput.txt for 16x16)
+ */
+void readGrid(grid2D* g, const char* inputName);
+void generateGrid(grid2D* g);
+/*
+ * binary grid files read and written by all the processes with MPI-IO (see jacobi_io.h)
+ */
+void readBinaryGrid(grid2D* g, const char* inputName);
+void writeBinaryGrid(grid2D* g, const char* outputName);
+/*
+ * exchange the 4 halos of g->grid with non-blocking communication
+ */
+void exchangeHalo(grid2D* g);
+/*
+ * one Jacobi sweep from g->grid to g->newGrid,
+ * returns the local sum of the squared differences
+ */
+float sweep(grid2D* g);
+/*
+ * nice print of the whole grid by process 0
+ */
+void printGrid(grid2D* g);
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int myid, int* rows, int* cols, char** inputName, char** outputName, int* isDisplay);
+
+/*
+ * to compile:
+ * mpicc -o jacobi2D jacobi2D.c jacobi_convergence.c jacobi_io.c jacobi_text.c -lm
+ * to run, e.g. on a 1024 x 1024 grid with 16 processes (4 x 4):
+ * mpirun -np 16 ./jacobi2D -r 1024 -c 1024
+ * mpirun -np 4 ./jacobi2D -r 16 -c 16 -i jacobiInput.txt -d
+ * binary input and output with MPI-IO (the size is read from the file):
+ * mpirun -np 4 ./jacobi2D -i jacobiInput.bin -o result.bin
+ */
+int main(int argc, char* argv[]){
+
+	MPI_Init(&argc, &argv);
+	grid2D g;
+	int rows = 16, cols = 16;
+	char* inputName = NULL;
+	char* outputName = NULL;
+	int isDisplay = 0;
+	int myid;
+	int iterations = 0;
+	float diffnorm;
+	float* swap;
+	jacobi_convergence convergenceCheck;
+	double startTime, elapsedTime;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	parseArgs(argc, argv, myid, &rows, &cols, &inputName, &outputName, &isDisplay);
+	if(inputName != NULL && jacobi_io_is_binary(inputName)){
+		if(!jacobi_io_read_size(MPI_COMM_WORLD, inputName, &rows, &cols)){
+			MPI_Finalize();
+			return 1;
+		}
+	}
+	createGrid(&g, rows, cols);
+	if(g.myid == 0){
+		printf("grid %d x %d, %d processes (%d x %d)\n", rows, cols, g.numprocs, g.dims[0], g.dims[1]);
+	}
+	if(inputName != NULL && jacobi_io_is_binary(inputName)){
+		readBinaryGrid(&g, inputName);
+	}else if(inputName != NULL){
+		readGrid(&g, inputName);
+	}else{
+		generateGrid(&g);
+	}
+
+	convergence_init(&convergenceCheck, g.cart, THRESHOLD, 1);
+	MPI_Barrier(g.cart);
+	startTime = MPI_Wtime();
+	int convergence = 1;
+	while(convergence && iterations < MAX_ITERATIONS){
+		exchangeHalo(&g);
+		diffnorm = sweep(&g);
+		/*
+		 * the new values become the current ones, the border values are the same in both
+		 */
+		swap = g.grid;
+		g.grid = g.newGrid;
+		g.newGrid = swap;
+		/*
+		 * checking for convergence: norm of the difference on the whole grid,
+		 * reduced while the next sweep is computed (see jacobi_convergence.h)
+		 */
+		if(convergence_update(&convergenceCheck, iterations, diffnorm)){
+			convergence = 0;
+		}
+		++iterations;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
+	}
+	convergence_free(&convergenceCheck);
+	elapsedTime = MPI_Wtime() - startTime;
+
+	if(isDisplay){
+		printGrid(&g);
+	}
+	if(outputName != NULL){
+		writeBinaryGrid(&g, outputName);
+	}
+	if(g.myid == 0){
+		printf("%d iterations, %lf (s)\n", iterations, elapsedTime);
+	}
+	freeGrid(&g);
+	MPI_Finalize();
+	return 0;
+}
+
+void partition(int n, int parts, int index, int* first, int* count){
+	*count = n/parts + (index < n%parts ? 1 : 0);
+	*first = index*(n/parts) + (index < n%parts ? index : n%parts);
+}
+
+void createGrid(grid2D* g, int rows, int cols){
+	int periods[2] = {0, 0};
+	long size;
+	g->rows = rows;
+	g->cols = cols;
+	MPI_Comm_size(MPI_COMM_WORLD, &g->numprocs);
+	/*
+	 * let MPI choose a balanced process grid, and allow reordering of the ranks
+	 */
+	g->dims[0] = g->dims[1] = 0;
+	MPI_Dims_create(g->numprocs, 2, g->dims);
+	MPI_Cart_create(MPI_COMM_WORLD, 2, g->dims, periods, 1, &g->cart);
+	MPI_Comm_rank(g->cart, &g->myid);
+	MPI_Cart_coords(g->cart, g->myid, 2, g->coords);
+	MPI_Cart_shift(g->cart, 0, 1, &g->up, &g->down);
+	MPI_Cart_shift(g->cart, 1, 1, &g->left, &g->right);
+	/*
+	 * the remainder rows/columns are spread over the first processes,
+	 * so the size does not have to be a multiple of the process number
+	 */
+	partition(rows, g->dims[0], g->coords[0], &g->firstRow, &g->localRows);
+	partition(cols, g->dims[1], g->coords[1], &g->firstCol, &g->localCols);
+	if(g->localRows < 1 || g->localCols < 1){
+		if(g->myid == 0) printf("Too many processes for a %d x %d grid\n", rows, cols);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	size = (long)(g->localRows+2)*(g->localCols+2);
+	g->grid = (float*) calloc(size, sizeof(float));
+	g->newGrid = (float*) calloc(size, sizeof(float));
+	if(g->grid == NULL || g->newGrid == NULL){
+		printf("Process %d: cannot allocate the grid\n", g->myid);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	/*
+	 * a column of the owned block: localRows floats with a stride of one row
+	 */
+	MPI_Type_vector(g->localRows, 1, g->localCols+2, MPI_FLOAT, &g->column);
+	MPI_Type_commit(&g->column);
+}
+
+void freeGrid(grid2D* g){
+	MPI_Type_free(&g->column);
+	MPI_Comm_free(&g->cart);
+	free(g->grid);
+	free(g->newGrid);
+}
+
+void generateGrid(grid2D* g){
+	int i, j, gi;
+	for(i=1;i<=g->localRows;++i){
+		gi = g->firstRow+i-1;
+		for(j=1;j<=g->localCols;++j){
+			if(gi == 0 || gi == g->rows-1){
+				AT(g, g->grid, i, j) = -1.0;
+			}else{
+				AT(g, g->grid, i, j) = (gi-1)%10;
+			}
+			AT(g, g->newGrid, i, j) = AT(g, g->grid, i, j);
+		}
+	}
+}
+
+void readGrid(grid2D* g, const char* inputName){
+	int i, j, c, owner, ownerCoords[2];
+	int first, count, ownerFirstRow, ownerRows;
+	float* row;
+	jacobi_text_reader input;
+	int ok = 1;
+	if(g->myid == 0){
+		if(!jacobi_text_open(&input, inputName)){
+			printf("Error reading Input\n");
+			ok = 0;
+		}
+	}
+	MPI_Bcast(&ok, 1, MPI_INT, 0, g->cart);
+	if(!ok) MPI_Abort(MPI_COMM_WORLD, 1);
+	/*
+	 * process 0 only holds one row of the grid at a time,
+	 * each piece of the row is sent to the process which owns it
+	 */
+	if(g->myid == 0){
+		row = (float*) malloc(sizeof(float)*g->cols);
+		for(i=0;i<g->rows;++i){
+			for(j=0;j<g->cols;++j){
+				if(!jacobi_text_next(&input, &row[j])) row[j] = 0.0;
+			}
+			for(ownerCoords[0]=0;ownerCoords[0]<g->dims[0];++ownerCoords[0]){
+				partition(g->rows, g->dims[0], ownerCoords[0], &ownerFirstRow, &ownerRows);
+				if(i < ownerFirstRow || i >= ownerFirstRow+ownerRows) continue;
+				for(c=0;c<g->dims[1];++c){
+					ownerCoords[1] = c;
+					partition(g->cols, g->dims[1], c, &first, &count);
+					MPI_Cart_rank(g->cart, ownerCoords, &owner);
+					if(owner == 0){
+						for(j=0;j<count;++j) AT(g, g->grid, i-g->firstRow+1, j+1) = row[first+j];
+					}else{
+						MPI_Send(&row[first], count, MPI_FLOAT, owner, ROW_TAG, g->cart);
+					}
+				}
+			}
+		}
+		free(row);
+		jacobi_text_close(&input);
+	}else{
+		for(i=1;i<=g->localRows;++i){
+			MPI_Recv(&AT(g, g->grid, i, 1), g->localCols, MPI_FLOAT, 0, ROW_TAG, g->cart, MPI_STATUS_IGNORE);
+		}
+	}
+	for(i=1;i<=g->localRows;++i){
+		for(j=1;j<=g->localCols;++j){
+			AT(g, g->newGrid, i, j) = AT(g, g->grid, i, j);
+		}
+	}
+}
+
+/*
+ * the owned block, inside the ghost cells of the local grid
+ */
+static void gridBlock(grid2D* g, jacobi_block* block){
+	block->rows = g->rows;
+	block->cols = g->cols;
+	block->firstRow = g->firstRow;
+	block->firstCol = g->firstCol;
+	block->localRows = g->localRows;
+	block->localCols = g->localCols;
+	block->memRows = g->localRows+2;
+	block->memCols = g->localCols+2;
+	block->memRow = 1;
+	block->memCol = 1;
+}
+
+void readBinaryGrid(grid2D* g, const char* inputName){
+	int i, j;
+	jacobi_block block;
+	gridBlock(g, &block);
+	if(!jacobi_io_read_block(g->cart, inputName, &block, g->grid)){
+		if(g->myid == 0) printf("Error reading Input\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	for(i=1;i<=g->localRows;++i){
+		for(j=1;j<=g->localCols;++j){
+			AT(g, g->newGrid, i, j) = AT(g, g->grid, i, j);
+		}
+	}
+}
+
+void writeBinaryGrid(grid2D* g, const char* outputName){
+	jacobi_block block;
+	gridBlock(g, &block);
+	if(!jacobi_io_write_block(g->cart, outputName, &block, g->grid)){
+		if(g->myid == 0) printf("Error writing %s\n", outputName);
+	}
+}
+
+void exchangeHalo(grid2D* g){
+	MPI_Request request[8];
+	int n = g->localRows, m = g->localCols;
+	/*
+	 * rows are contiguous, columns use the derived datatype.
+	 * at the border of the domain the neighbor is MPI_PROC_NULL, and the call does nothing
+	 */
+	MPI_Irecv(&AT(g, g->grid, 0, 1), m, MPI_FLOAT, g->up, 17, g->cart, &request[0]);
+	MPI_Irecv(&AT(g, g->grid, n+1, 1), m, MPI_FLOAT, g->down, 23, g->cart, &request[1]);
+	MPI_Irecv(&AT(g, g->grid, 1, 0), 1, g->column, g->left, 29, g->cart, &request[2]);
+	MPI_Irecv(&AT(g, g->grid, 1, m+1), 1, g->column, g->right, 31, g->cart, &request[3]);
+	MPI_Isend(&AT(g, g->grid, n, 1), m, MPI_FLOAT, g->down, 17, g->cart, &request[4]);
+	MPI_Isend(&AT(g, g->grid, 1, 1), m, MPI_FLOAT, g->up, 23, g->cart, &request[5]);
+	MPI_Isend(&AT(g, g->grid, 1, m), 1, g->column, g->right, 29, g->cart, &request[6]);
+	MPI_Isend(&AT(g, g->grid, 1, 1), 1, g->column, g->left, 31, g->cart, &request[7]);
+	MPI_Waitall(8, request, MPI_STATUSES_IGNORE);
+}
+
+float sweep(grid2D* g){
+	int i, j;
+	int iFirst = 1, iLast = g->localRows;
+	int jFirst = 1, jLast = g->localCols;
+	float diffnorm = 0.0;
+	float* grid = g->grid;
+	float* newGrid = g->newGrid;
+	/*
+	 * the first/last rows and columns of the whole grid are fixed
+	 */
+	if(g->firstRow == 0) iFirst = 2;
+	if(g->firstRow+g->localRows == g->rows) iLast = g->localRows-1;
+	if(g->firstCol == 0) jFirst = 2;
+	if(g->firstCol+g->localCols == g->cols) jLast = g->localCols-1;
+	for(i=iFirst;i<=iLast;++i){
+		for(j=jFirst;j<=jLast;++j){
+			AT(g, newGrid, i, j) = (AT(g, grid, i-1, j)+AT(g, grid, i+1, j)+AT(g, grid, i, j-1)+AT(g, grid, i, j+1))/4.0;
+			diffnorm += (AT(g, newGrid, i, j) - AT(g, grid, i, j))*(AT(g, newGrid, i, j) - AT(g, grid, i, j));
+		}
+	}
+	return diffnorm;
+}
+
+void printGrid(grid2D* g){
+	int i, j, c, owner, ownerCoords[2];
+	int first, count, ownerFirstRow, ownerRows;
+	float* row;
+	/*
+	 * reverse of readGrid: process 0 collects and prints one row at a time
+	 */
+	if(g->myid == 0){
+		row = (float*) malloc(sizeof(float)*g->cols);
+		for(i=0;i<g->rows;++i){
+			for(ownerCoords[0]=0;ownerCoords[0]<g->dims[0];++ownerCoords[0]){
+				partition(g->rows, g->dims[0], ownerCoords[0], &ownerFirstRow, &ownerRows);
+				if(i < ownerFirstRow || i >= ownerFirstRow+ownerRows) continue;
+				for(c=0;c<g->dims[1];++c){
+					ownerCoords[1] = c;
+					partition(g->cols, g->dims[1], c, &first, &count);
+					MPI_Cart_rank(g->cart, ownerCoords, &owner);
+					if(owner == 0){
+						for(j=0;j<count;++j) row[first+j] = AT(g, g->grid, i-g->firstRow+1, j+1);
+					}else{
+						MPI_Recv(&row[first], count, MPI_FLOAT, owner, ROW_TAG, g->cart, MPI_STATUS_IGNORE);
+					}
+				}
+			}
+			for(j=0;j<g->cols;++j){
+				printf("%.4f ", row[j]);
+			}
+			printf("\n");
+		}
+		printf("\n");
+		free(row);
+	}else{
+		for(i=1;i<=g->localRows;++i){
+			MPI_Send(&AT(g, g->grid, i, 1), g->localCols, MPI_FLOAT, 0, ROW_TAG, g->cart);
+		}
+	}
+}
+
+void parseArgs(int argc, char** argv, int myid, int* rows, int* cols, char** inputName, char** outputName, int* isDisplay){
+	int c;
+	while((c=getopt(argc, argv, "r:c:i:o:d")) != -1){
+		switch(c){
+			case 'r':
+				*rows = atoi(optarg);
+				break;
+			case 'c':
+				*cols = atoi(optarg);
+				break;
+			case 'i':
+				*inputName = optarg;
+				break;
+			case 'o':
+				*outputName = optarg;
+				break;
+			case 'd':
+				*isDisplay = 1;
+				break;
+			default:
+				if(myid == 0) printf("usage: %s [-r rows] [-c cols] [-i input] [-o output.bin] [-d]\n", argv[0]);
+				MPI_Finalize();
+				exit(1);
+		}
+	}
+	if(*rows < 3 || *cols < 3){
+		if(myid == 0) printf("The grid must have at least 3 rows and 3 columns\n");
+		MPI_Finalize();
+		exit(1);
+	}
+}
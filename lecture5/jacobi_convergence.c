@@ -0,0 +1,45 @@
+#include <math.h>
+#include <mpi.h>
+#include "jacobi_convergence.h"
+
+void convergence_init(jacobi_convergence* c, MPI_Comm comm, double threshold, int interval){
+	c->comm = comm;
+	c->threshold = threshold;
+	c->interval = (interval > 0) ? interval : 1;
+	c->pending = 0;
+	c->checks = 0;
+	c->norm = -1.0;
+	c->request = MPI_REQUEST_NULL;
+}
+
+int convergence_needed(jacobi_convergence* c, int iteration){
+	return (iteration % c->interval) == 0;
+}
+
+int convergence_update(jacobi_convergence* c, int iteration, double localSquaredNorm){
+	/*
+	 * the reduction started after a previous sweep has been overlapped with this sweep
+	 */
+	if(c->pending){
+		MPI_Wait(&c->request, MPI_STATUS_IGNORE);
+		c->pending = 0;
+		++c->checks;
+		c->norm = sqrt(c->globalSum);
+		if(c->norm < c->threshold){
+			return 1;
+		}
+	}
+	if(convergence_needed(c, iteration)){
+		c->localSum = localSquaredNorm;
+		MPI_Iallreduce(&c->localSum, &c->globalSum, 1, MPI_DOUBLE, MPI_SUM, c->comm, &c->request);
+		c->pending = 1;
+	}
+	return 0;
+}
+
+void convergence_free(jacobi_convergence* c){
+	if(c->pending){
+		MPI_Wait(&c->request, MPI_STATUS_IGNORE);
+		c->pending = 0;
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef JACOBI_CONVERGENCE_H
+#define JACOBI_CONVERGENCE_H
+#include <mpi.h>
+
+/*
+ * Convergence check of the Jacobi solvers:
+ * the squared norm of the difference between two iterates is summed over all the processes
+ * with one MPI_Iallreduce (instead of MPI_Reduce to process 0 and MPI_Bcast of the decision),
+ * and the square root is taken on the global sum.
+ *
+ * The reduction is started after a sweep and completed after the next sweep,
+ * so it is overlapped with the computation; all the processes get the same sum
+ * and stop at the same iteration.
+ * With an interval k > 1, the norm is only reduced every k sweeps.
+ * The convergence is detected one sweep after the sweep whose norm is below the threshold.
+ */
+typedef struct{
+	MPI_Comm comm;
+	double threshold;
+	int interval;		/* check every interval sweeps */
+	double localSum;	/* buffers of the reduction in progress */
+	double globalSum;
+	MPI_Request request;
+	int pending;		/* a reduction is in progress */
+	int checks;		/* number of completed reductions */
+	double norm;		/* last global norm */
+} jacobi_convergence;
+
+void convergence_init(jacobi_convergence* c, MPI_Comm comm, double threshold, int interval);
+/*
+ * 1 if the squared norm of sweep number iteration has to be given to convergence_update()
+ */
+int convergence_needed(jacobi_convergence* c, int iteration);
+/*
+ * to call after every sweep (iteration = 0, 1, 2, ...),
+ * with the local sum of the squared differences of this sweep (only used if convergence_needed()).
+ * completes the reduction of a previous sweep, starts the reduction of this sweep,
+ * returns 1 when the global norm of a previous sweep is below the threshold
+ */
+int convergence_update(jacobi_convergence* c, int iteration, double localSquaredNorm);
+/* completes the reduction in progress */
+void convergence_free(jacobi_convergence* c);
+
+#endif
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include "jacobi_io.h"
+#include "jacobi_text.h"
+
+/*
+ * Conversion of the grid files, one row at a time:
+ * text (the format of jacobiInput.txt) to binary (jacobi_io.h), and binary to text.
+ * the direction is given by the extension of the input, .bin for a binary file
+ */
+
+/* text file of rows x cols values to binary file, returns 0 on error */
+int textToBinary(const char* inputName, const char* outputName, int rows, int cols);
+/* binary file to text file, returns 0 on error */
+int binaryToText(const char* inputName, const char* outputName);
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int* rows, int* cols, char** inputName, char** outputName);
+
+/*
+ * to compile:
+ * mpicc -o jacobi_convert jacobi_convert.c jacobi_io.c jacobi_text.c
+ * to run:
+ * ./jacobi_convert -r 16 -c 16 jacobiInput.txt jacobiInput.bin
+ * ./jacobi_convert result.bin result.txt
+ */
+int main(int argc, char* argv[]){
+
+	int rows = 16, cols = 16;
+	char *inputName, *outputName;
+	int ok;
+
+	parseArgs(argc, argv, &rows, &cols, &inputName, &outputName);
+	if(jacobi_io_is_binary(inputName)){
+		ok = binaryToText(inputName, outputName);
+	}else{
+		ok = textToBinary(inputName, outputName, rows, cols);
+	}
+	return ok ? 0 : 1;
+}
+
+int textToBinary(const char* inputName, const char* outputName, int rows, int cols){
+	int i, j;
+	jacobi_text_reader input;
+	FILE* output;
+	jacobi_io_header header;
+	float* row = (float*) malloc(sizeof(float)*cols);
+	if(!jacobi_text_open(&input, inputName)){
+		printf("Error opening %s\n", inputName);
+		return 0;
+	}
+	output = fopen(outputName, "wb");
+	if(output == NULL || row == NULL){
+		printf("Error opening %s\n", outputName);
+		jacobi_text_close(&input);
+		return 0;
+	}
+	jacobi_io_header_init(&header, rows, cols);
+	fwrite(&header, sizeof(header), 1, output);
+	for(i=0;i<rows;++i){
+		for(j=0;j<cols;++j){
+			if(!jacobi_text_next(&input, &row[j])) row[j] = 0.0;
+		}
+		fwrite(row, sizeof(float), cols, output);
+	}
+	free(row);
+	jacobi_text_close(&input);
+	fclose(output);
+	return 1;
+}
+
+int binaryToText(const char* inputName, const char* outputName){
+	int i, j;
+	FILE *input, *output;
+	jacobi_io_header header;
+	float* row;
+	input = fopen(inputName, "rb");
+	output = fopen(outputName, "w");
+	if(input == NULL || output == NULL){
+		printf("Error opening %s or %s\n", inputName, outputName);
+		return 0;
+	}
+	if(fread(&header, sizeof(header), 1, input) != 1 || !jacobi_io_header_check(&header, inputName)){
+		fclose(input);
+		fclose(output);
+		return 0;
+	}
+	row = (float*) malloc(sizeof(float)*header.cols);
+	fseek(input, header.offset, SEEK_SET);
+	for(i=0;i<header.rows;++i){
+		if(fread(row, sizeof(float), header.cols, input) != (size_t) header.cols){
+			printf("%s is too short\n", inputName);
+			break;
+		}
+		for(j=0;j<header.cols;++j){
+			fprintf(output, "%.4f ", row[j]);
+		}
+		fprintf(output, "\n");
+	}
+	free(row);
+	fclose(input);
+	fclose(output);
+	return 1;
+}
+
+void parseArgs(int argc, char** argv, int* rows, int* cols, char** inputName, char** outputName){
+	int c;
+	while((c=getopt(argc, argv, "r:c:")) != -1){
+		switch(c){
+			case 'r':
+				*rows = atoi(optarg);
+				break;
+			case 'c':
+				*cols = atoi(optarg);
+				break;
+			default:
+				printf("usage: %s [-r rows] [-c cols] input output\n", argv[0]);
+				exit(1);
+		}
+	}
+	if(argc-optind != 2 || *rows < 1 || *cols < 1){
+		printf("usage: %s [-r rows] [-c cols] input output\n", argv[0]);
+		exit(1);
+	}
+	*inputName = argv[optind];
+	*outputName = argv[optind+1];
+}
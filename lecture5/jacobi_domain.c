@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "jacobi_domain.h"
+#include "jacobi_text.h"
+
+/*
+ * tag of the rows sent between process 0 and the owners: the messages between 2 processes
+ * arrive in the order they are sent, which is the order of the rows
+ * (a row index could be above the largest tag guaranteed by MPI, 32767)
+ */
+#define ROW_TAG 37
+
+static const char* haloModeNames[HALO_MODES] = {"blocking", "ordered", "nonblocking", "persistent", "neighbor"};
+
+void jacobi_partition(int n, int parts, int index, int* first, int* count){
+	*count = n/parts + (index < n%parts ? 1 : 0);
+	*first = index*(n/parts) + (index < n%parts ? index : n%parts);
+}
+
+int jacobi_domain_create(jacobi_domain* d, MPI_Comm comm, int rows, int cols, int depth, halo_mode mode){
+	int myid, numprocs, firstRow, localRows;
+	MPI_Comm_rank(comm, &myid);
+	MPI_Comm_size(comm, &numprocs);
+	jacobi_partition(rows, numprocs, myid, &firstRow, &localRows);
+	return jacobi_domain_create_rows(d, comm, rows, cols, firstRow, localRows, depth, mode);
+}
+
+int jacobi_domain_create_rows(jacobi_domain* d, MPI_Comm comm, int rows, int cols, int firstRow, int localRows, int depth, halo_mode mode){
+	int dims[1], periods[1] = {0};
+	int b, ok, allOk, n, count;
+	long size;
+	memset(d, 0, sizeof(jacobi_domain));
+	d->rows = rows;
+	d->cols = cols;
+	d->depth = depth;
+	d->mode = mode;
+	/*
+	 * a 1D cartesian communicator: the neighbors are given by MPI_Cart_shift,
+	 * and the neighbor collectives can be used on it
+	 */
+	MPI_Comm_size(comm, &d->numprocs);
+	dims[0] = d->numprocs;
+	MPI_Cart_create(comm, 1, dims, periods, 0, &d->comm);
+	MPI_Comm_rank(d->comm, &d->myid);
+	MPI_Cart_shift(d->comm, 0, 1, &d->up, &d->down);
+	d->firstRow = firstRow;
+	d->localRows = localRows;
+	/**/
+	ok = (d->localRows >= depth && depth > 0);
+	MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, d->comm);
+	if(!allOk){
+		MPI_Comm_free(&d->comm);
+		return 0;
+	}
+	n = d->localRows;
+	count = depth*cols;
+	size = (long)(n+2*depth)*cols;
+	for(b=0;b<2;++b){
+		d->buffer[b] = (float*) calloc(size, sizeof(float));
+		if(d->buffer[b] == NULL){
+			printf("Process %d: cannot allocate the grid\n", d->myid);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+	}
+	d->current = 0;
+	/*
+	 * persistent requests, created once for each of the 2 buffers
+	 * (the buffers are swapped after each sweep)
+	 */
+	if(mode == HALO_PERSISTENT){
+		for(b=0;b<2;++b){
+			MPI_Recv_init(ROW(d, d->buffer[b], 1-depth), count, MPI_FLOAT, d->up, 17, d->comm, &d->persistent[b][0]);
+			MPI_Recv_init(ROW(d, d->buffer[b], n+1), count, MPI_FLOAT, d->down, 23, d->comm, &d->persistent[b][1]);
+			MPI_Send_init(ROW(d, d->buffer[b], n-depth+1), count, MPI_FLOAT, d->down, 17, d->comm, &d->persistent[b][2]);
+			MPI_Send_init(ROW(d, d->buffer[b], 1), count, MPI_FLOAT, d->up, 23, d->comm, &d->persistent[b][3]);
+		}
+	}
+	/*
+	 * neighbor collective: the neighbors of a 1D cartesian communicator are (up, down).
+	 * with alltoallw, the displacements are in bytes from the start of the buffer,
+	 * so the rows are sent and received in place, without packing
+	 */
+	if(mode == HALO_NEIGHBOR){
+		d->counts[0] = d->counts[1] = count;
+		d->types[0] = d->types[1] = MPI_FLOAT;
+		d->sendDispls[0] = (MPI_Aint) sizeof(float)*cols*depth;
+		d->sendDispls[1] = (MPI_Aint) sizeof(float)*cols*n;
+		d->recvDispls[0] = 0;
+		d->recvDispls[1] = (MPI_Aint) sizeof(float)*cols*(n+depth);
+	}
+	return 1;
+}
+
+void jacobi_domain_free(jacobi_domain* d){
+	int b, r;
+	if(d->mode == HALO_PERSISTENT){
+		for(b=0;b<2;++b){
+			for(r=0;r<4;++r){
+				MPI_Request_free(&d->persistent[b][r]);
+			}
+		}
+	}
+	free(d->buffer[0]);
+	free(d->buffer[1]);
+	MPI_Comm_free(&d->comm);
+}
+
+float* jacobi_grid(jacobi_domain* d){
+	return d->buffer[d->current];
+}
+
+float* jacobi_new_grid(jacobi_domain* d){
+	return d->buffer[1-d->current];
+}
+
+void jacobi_swap(jacobi_domain* d){
+	d->current = 1-d->current;
+}
+
+void jacobi_domain_generate(jacobi_domain* d){
+	int i, j, gi;
+	float value;
+	for(i=1;i<=d->localRows;++i){
+		gi = d->firstRow+i-1;
+		if(gi == 0 || gi == d->rows-1){
+			value = -1.0;
+		}else{
+			value = (gi-1)%10;
+		}
+		for(j=0;j<d->cols;++j){
+			ROW(d, d->buffer[0], i)[j] = value;
+			ROW(d, d->buffer[1], i)[j] = value;
+		}
+	}
+}
+
+int jacobi_domain_read_text(jacobi_domain* d, const char* inputName){
+	int i, j, owner, first, count;
+	float* row;
+	jacobi_text_reader input;
+	int ok = 1;
+	if(d->myid == 0){
+		if(!jacobi_text_open(&input, inputName)){
+			printf("Error reading Input\n");
+			ok = 0;
+		}
+	}
+	MPI_Bcast(&ok, 1, MPI_INT, 0, d->comm);
+	if(!ok) return 0;
+	/*
+	 * process 0 only holds one row at a time
+	 */
+	if(d->myid == 0){
+		row = (float*) malloc(sizeof(float)*d->cols);
+		owner = 0;
+		jacobi_partition(d->rows, d->numprocs, owner, &first, &count);
+		for(i=0;i<d->rows;++i){
+			for(j=0;j<d->cols;++j){
+				if(!jacobi_text_next(&input, &row[j])) row[j] = 0.0;
+			}
+			while(i >= first+count){
+				++owner;
+				jacobi_partition(d->rows, d->numprocs, owner, &first, &count);
+			}
+			if(owner == 0){
+				memcpy(ROW(d, d->buffer[0], i+1), row, sizeof(float)*d->cols);
+			}else{
+				MPI_Send(row, d->cols, MPI_FLOAT, owner, ROW_TAG, d->comm);
+			}
+		}
+		free(row);
+		jacobi_text_close(&input);
+	}else{
+		for(i=1;i<=d->localRows;++i){
+			MPI_Recv(ROW(d, d->buffer[0], i), d->cols, MPI_FLOAT, 0, ROW_TAG, d->comm, MPI_STATUS_IGNORE);
+		}
+	}
+	memcpy(d->buffer[1], d->buffer[0], sizeof(float)*(d->localRows+2*d->depth)*d->cols);
+	d->current = 0;
+	return 1;
+}
+
+void jacobi_domain_print(jacobi_domain* d){
+	int i, j, owner, first, count;
+	float* row;
+	float* grid = jacobi_grid(d);
+	if(d->myid == 0){
+		row = (float*) malloc(sizeof(float)*d->cols);
+		owner = 0;
+		jacobi_partition(d->rows, d->numprocs, owner, &first, &count);
+		for(i=0;i<d->rows;++i){
+			while(i >= first+count){
+				++owner;
+				jacobi_partition(d->rows, d->numprocs, owner, &first, &count);
+			}
+			if(owner == 0){
+				memcpy(row, ROW(d, grid, i+1), sizeof(float)*d->cols);
+			}else{
+				MPI_Recv(row, d->cols, MPI_FLOAT, owner, ROW_TAG, d->comm, MPI_STATUS_IGNORE);
+			}
+			for(j=0;j<d->cols;++j){
+				printf("%.4f ", row[j]);
+			}
+			printf("\n");
+		}
+		printf("\n");
+		free(row);
+	}else{
+		for(i=1;i<=d->localRows;++i){
+			MPI_Send(ROW(d, grid, i), d->cols, MPI_FLOAT, 0, ROW_TAG, d->comm);
+		}
+	}
+}
+
+void halo_start(jacobi_domain* d){
+	float* grid = jacobi_grid(d);
+	int n = d->localRows, h = d->depth, m = d->depth*d->cols;
+	d->requestNumber = 0;
+	switch(d->mode){
+		case HALO_BLOCKING:
+			/*
+			 * the rows go down the chain of processes, then up
+			 */
+			MPI_Recv(ROW(d, grid, 1-h), m, MPI_FLOAT, d->up, 17, d->comm, MPI_STATUS_IGNORE);
+			MPI_Send(ROW(d, grid, n-h+1), m, MPI_FLOAT, d->down, 17, d->comm);
+			MPI_Send(ROW(d, grid, 1), m, MPI_FLOAT, d->up, 23, d->comm);
+			MPI_Recv(ROW(d, grid, n+1), m, MPI_FLOAT, d->down, 23, d->comm, MPI_STATUS_IGNORE);
+			break;
+		case HALO_ORDERED:
+			/*
+			 * phase 1: down, phase 2: up.
+			 * even processes send first, odd processes receive first
+			 */
+			if((d->myid%2) == 0){
+				MPI_Send(ROW(d, grid, n-h+1), m, MPI_FLOAT, d->down, 13, d->comm);
+				MPI_Recv(ROW(d, grid, 1-h), m, MPI_FLOAT, d->up, 13, d->comm, MPI_STATUS_IGNORE);
+				MPI_Send(ROW(d, grid, 1), m, MPI_FLOAT, d->up, 31, d->comm);
+				MPI_Recv(ROW(d, grid, n+1), m, MPI_FLOAT, d->down, 31, d->comm, MPI_STATUS_IGNORE);
+			}else{
+				MPI_Recv(ROW(d, grid, 1-h), m, MPI_FLOAT, d->up, 13, d->comm, MPI_STATUS_IGNORE);
+				MPI_Send(ROW(d, grid, n-h+1), m, MPI_FLOAT, d->down, 13, d->comm);
+				MPI_Recv(ROW(d, grid, n+1), m, MPI_FLOAT, d->down, 31, d->comm, MPI_STATUS_IGNORE);
+				MPI_Send(ROW(d, grid, 1), m, MPI_FLOAT, d->up, 31, d->comm);
+			}
+			break;
+		case HALO_NONBLOCKING:
+			MPI_Irecv(ROW(d, grid, 1-h), m, MPI_FLOAT, d->up, 17, d->comm, &d->request[0]);
+			MPI_Irecv(ROW(d, grid, n+1), m, MPI_FLOAT, d->down, 23, d->comm, &d->request[1]);
+			MPI_Isend(ROW(d, grid, n-h+1), m, MPI_FLOAT, d->down, 17, d->comm, &d->request[2]);
+			MPI_Isend(ROW(d, grid, 1), m, MPI_FLOAT, d->up, 23, d->comm, &d->request[3]);
+			d->requestNumber = 4;
+			break;
+		case HALO_PERSISTENT:
+			MPI_Startall(4, d->persistent[d->current]);
+			break;
+		case HALO_NEIGHBOR:
+			MPI_Ineighbor_alltoallw(grid, d->counts, d->sendDispls, d->types,
+				grid, d->counts, d->recvDispls, d->types, d->comm, &d->request[0]);
+			d->requestNumber = 1;
+			break;
+		default:
+			break;
+	}
+}
+
+void halo_finish(jacobi_domain* d){
+	if(d->mode == HALO_PERSISTENT){
+		MPI_Waitall(4, d->persistent[d->current], MPI_STATUSES_IGNORE);
+	}else if(d->requestNumber > 0){
+		MPI_Waitall(d->requestNumber, d->request, MPI_STATUSES_IGNORE);
+		d->requestNumber = 0;
+	}
+}
+
+const char* halo_mode_name(halo_mode mode){
+	if(mode < 0 || mode >= HALO_MODES) return "unknown";
+	return haloModeNames[mode];
+}
+
+int halo_mode_parse(const char* name){
+	int mode;
+	for(mode=0;mode<HALO_MODES;++mode){
+		if(strcmp(name, haloModeNames[mode]) == 0) return mode;
+	}
+	return -1;
+}
@@ -0,0 +1,99 @@
+#ifndef JACOBI_DOMAIN_H
+#define JACOBI_DOMAIN_H
+#include <mpi.h>
+
+/*
+ * Row decomposition of a rows x cols grid, used by jacobi1D_version_4.c:
+ * each process owns localRows consecutive rows, stored in rows 1..localRows
+ * of a buffer with depth ghost rows above (rows 1-depth..0) and below (rows localRows+1..localRows+depth).
+ * The ghost rows of the first/last process are not used
+ * (the neighbor is MPI_PROC_NULL and the border rows of the grid are fixed).
+ * With a deep halo (depth > 1), one exchange gives enough rows for depth sweeps
+ * without communication (see jacobi_kernel.h).
+ *
+ * Two buffers are allocated, the current grid and the new grid,
+ * jacobi_swap() exchanges them after a sweep instead of copying the values back.
+ */
+
+/*
+ * the halo exchange modes:
+ * HALO_BLOCKING	MPI_Send/MPI_Recv in a chain, as in jacobi1D_version_1.c
+ * HALO_ORDERED		MPI_Send/MPI_Recv, even/odd ranks in 2 phases, as in jacobi1D_version_2.c
+ * HALO_NONBLOCKING	MPI_Isend/MPI_Irecv posted every iteration, as in jacobi1D_version_3.c
+ * HALO_PERSISTENT	MPI_Send_init/MPI_Recv_init created once, MPI_Startall every iteration
+ * HALO_NEIGHBOR	MPI_Ineighbor_alltoallw on the cartesian communicator
+ */
+typedef enum{
+	HALO_BLOCKING = 0,
+	HALO_ORDERED,
+	HALO_NONBLOCKING,
+	HALO_PERSISTENT,
+	HALO_NEIGHBOR,
+	HALO_MODES
+} halo_mode;
+
+typedef struct{
+	int rows, cols;			/* global grid size */
+	MPI_Comm comm;			/* 1D cartesian communicator */
+	int myid, numprocs;
+	int up, down;			/* neighbors, MPI_PROC_NULL at the border */
+	int firstRow, localRows;	/* global index of the first owned row, number of owned rows */
+	int depth;			/* number of ghost rows on each side */
+	float* buffer[2];		/* (localRows+2*depth) x cols, with ghost rows */
+	int current;			/* buffer[current] is the current grid */
+	halo_mode mode;
+	MPI_Request request[4];		/* requests of the exchange in progress */
+	int requestNumber;
+	MPI_Request persistent[2][4];	/* HALO_PERSISTENT: one set of requests per buffer */
+	int counts[2];			/* HALO_NEIGHBOR: arguments of MPI_Ineighbor_alltoallw */
+	MPI_Aint sendDispls[2], recvDispls[2];
+	MPI_Datatype types[2];
+} jacobi_domain;
+
+/* row i (1-depth..localRows+depth) of a local buffer */
+#define ROW(d,grid,i) ((grid)+(long)((i)+(d)->depth-1)*(d)->cols)
+
+/*
+ * balanced block distribution of n elements among parts,
+ * the first n%parts parts get one more element
+ */
+void jacobi_partition(int n, int parts, int index, int* first, int* count);
+/*
+ * distribute the rows among the processes of comm and allocate the buffers with depth ghost rows,
+ * returns 0 if a process gets less than depth rows (the ghost rows only come from the direct neighbors)
+ */
+int jacobi_domain_create(jacobi_domain* d, MPI_Comm comm, int rows, int cols, int depth, halo_mode mode);
+/*
+ * the same with the rows firstRow..firstRow+localRows-1 given by the caller
+ * (consecutive blocks in the order of the ranks of comm, e.g. for the coarse grids of jacobi_multigrid.c)
+ */
+int jacobi_domain_create_rows(jacobi_domain* d, MPI_Comm comm, int rows, int cols, int firstRow, int localRows, int depth, halo_mode mode);
+void jacobi_domain_free(jacobi_domain* d);
+/* the current grid and the grid of the next sweep */
+float* jacobi_grid(jacobi_domain* d);
+float* jacobi_new_grid(jacobi_domain* d);
+/* the new grid becomes the current one */
+void jacobi_swap(jacobi_domain* d);
+/*
+ * initial values, in both buffers:
+ * generated (the same values as jacobiInput.txt for 16x16),
+ * or read from a text file by process 0, one row at a time sent to its owner
+ * returns 0 if the file cannot be read
+ */
+void jacobi_domain_generate(jacobi_domain* d);
+int jacobi_domain_read_text(jacobi_domain* d, const char* inputName);
+/* nice print of the current grid by process 0 */
+void jacobi_domain_print(jacobi_domain* d);
+/*
+ * exchange of the depth ghost rows of the current grid:
+ * halo_start() begins the exchange, halo_finish() completes it.
+ * with depth 1, the rows 2..localRows-1 can be computed in between;
+ * the blocking modes do the whole exchange in halo_start()
+ */
+void halo_start(jacobi_domain* d);
+void halo_finish(jacobi_domain* d);
+/* name of a mode, and mode of a name (-1 if unknown) */
+const char* halo_mode_name(halo_mode mode);
+int halo_mode_parse(const char* name);
+
+#endif
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "jacobi_io.h"
+
+/*
+ * the subarray of the block in the file and in the local array
+ */
+static void blockTypes(const jacobi_block* block, MPI_Datatype* fileType, MPI_Datatype* memType){
+	int sizes[2], subsizes[2], starts[2];
+	sizes[0] = block->rows;
+	sizes[1] = block->cols;
+	subsizes[0] = block->localRows;
+	subsizes[1] = block->localCols;
+	starts[0] = block->firstRow;
+	starts[1] = block->firstCol;
+	MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_FLOAT, fileType);
+	MPI_Type_commit(fileType);
+	sizes[0] = block->memRows;
+	sizes[1] = block->memCols;
+	starts[0] = block->memRow;
+	starts[1] = block->memCol;
+	MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_FLOAT, memType);
+	MPI_Type_commit(memType);
+}
+
+void jacobi_io_header_init(jacobi_io_header* header, int rows, int cols){
+	memset(header, 0, sizeof(jacobi_io_header));
+	strncpy(header->magic, JACOBI_IO_MAGIC, sizeof(header->magic));
+	header->version = JACOBI_IO_VERSION;
+	header->byteOrder = 1;
+	header->type = JACOBI_IO_FLOAT32;
+	header->rows = rows;
+	header->cols = cols;
+	header->offset = JACOBI_IO_HEADER_SIZE;
+}
+
+int jacobi_io_header_check(const jacobi_io_header* header, const char* name){
+	if(strncmp(header->magic, JACOBI_IO_MAGIC, sizeof(header->magic)) != 0){
+		printf("%s is not a binary grid file\n", name);
+		return 0;
+	}
+	if(header->byteOrder != 1){
+		printf("%s has another byte order\n", name);
+		return 0;
+	}
+	if(header->version != JACOBI_IO_VERSION || header->type != JACOBI_IO_FLOAT32 || header->rows < 1 || header->cols < 1
+		|| header->offset < JACOBI_IO_HEADER_SIZE){
+		printf("%s: unsupported version, type or size\n", name);
+		return 0;
+	}
+	return 1;
+}
+
+int jacobi_io_is_binary(const char* name){
+	size_t length = strlen(name);
+	return length > 4 && strcmp(name+length-4, ".bin") == 0;
+}
+
+int jacobi_io_read_size(MPI_Comm comm, const char* name, int* rows, int* cols){
+	int myid;
+	int values[3] = {0, 0, 0};
+	jacobi_io_header header;
+	FILE* input;
+	MPI_Comm_rank(comm, &myid);
+	if(myid == 0){
+		input = fopen(name, "rb");
+		if(input == NULL){
+			printf("Error reading Input\n");
+		}else{
+			if(fread(&header, sizeof(header), 1, input) == 1 && jacobi_io_header_check(&header, name)){
+				values[0] = 1;
+				values[1] = header.rows;
+				values[2] = header.cols;
+			}
+			fclose(input);
+		}
+	}
+	MPI_Bcast(values, 3, MPI_INT, 0, comm);
+	*rows = values[1];
+	*cols = values[2];
+	return values[0];
+}
+
+int jacobi_io_read_block(MPI_Comm comm, const char* name, const jacobi_block* block, float* buffer){
+	MPI_File file;
+	MPI_Datatype fileType, memType;
+	jacobi_io_header header;
+	int myid, ok = 1, allOk;
+	MPI_Comm_rank(comm, &myid);
+	if(MPI_File_open(comm, (char*) name, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS){
+		return 0;
+	}
+	/*
+	 * every process reads the header, a small collective read,
+	 * the same header for all: process 0 reports why it is refused
+	 */
+	MPI_File_read_at_all(file, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+	if(myid == 0){
+		ok = jacobi_io_header_check(&header, name);
+	}else{
+		ok = strncmp(header.magic, JACOBI_IO_MAGIC, sizeof(header.magic)) == 0;
+	}
+	if(ok && (header.rows != block->rows || header.cols != block->cols)){
+		if(myid == 0) printf("%s: a grid of %d x %d, not %d x %d\n", name, header.rows, header.cols, block->rows,
+			block->cols);
+		ok = 0;
+	}
+	MPI_Allreduce(&ok, &allOk, 1, MPI_INT, MPI_MIN, comm);
+	if(!allOk){
+		MPI_File_close(&file);
+		return 0;
+	}
+	blockTypes(block, &fileType, &memType);
+	MPI_File_set_view(file, header.offset, MPI_FLOAT, fileType, "native", MPI_INFO_NULL);
+	MPI_File_read_at_all(file, 0, buffer, 1, memType, MPI_STATUS_IGNORE);
+	MPI_File_close(&file);
+	MPI_Type_free(&fileType);
+	MPI_Type_free(&memType);
+	return 1;
+}
+
+int jacobi_io_write_block(MPI_Comm comm, const char* name, const jacobi_block* block, float* buffer){
+	MPI_File file;
+	MPI_Datatype fileType, memType;
+	jacobi_io_header header;
+	int myid;
+	MPI_Comm_rank(comm, &myid);
+	if(MPI_File_open(comm, (char*) name, MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &file) != MPI_SUCCESS){
+		return 0;
+	}
+	MPI_File_set_size(file, JACOBI_IO_HEADER_SIZE + (MPI_Offset) sizeof(float)*block->rows*block->cols);
+	jacobi_io_header_init(&header, block->rows, block->cols);
+	if(myid == 0){
+		MPI_File_write_at(file, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+	}
+	blockTypes(block, &fileType, &memType);
+	MPI_File_set_view(file, header.offset, MPI_FLOAT, fileType, "native", MPI_INFO_NULL);
+	MPI_File_write_at_all(file, 0, buffer, 1, memType, MPI_STATUS_IGNORE);
+	MPI_File_close(&file);
+	MPI_Type_free(&fileType);
+	MPI_Type_free(&memType);
+	return 1;
+}
+
+/*
+ * the owned rows of a row decomposition
+ */
+static void domainBlock(jacobi_domain* d, jacobi_block* block){
+	block->rows = d->rows;
+	block->cols = d->cols;
+	block->firstRow = d->firstRow;
+	block->firstCol = 0;
+	block->localRows = d->localRows;
+	block->localCols = d->cols;
+	block->memRows = d->localRows+2*d->depth;
+	block->memCols = d->cols;
+	block->memRow = d->depth;
+	block->memCol = 0;
+}
+
+int jacobi_domain_read(jacobi_domain* d, const char* name){
+	jacobi_block block;
+	domainBlock(d, &block);
+	d->current = 0;
+	if(!jacobi_io_read_block(d->comm, name, &block, d->buffer[0])){
+		if(d->myid == 0) printf("Error reading Input\n");
+		return 0;
+	}
+	memcpy(d->buffer[1], d->buffer[0], sizeof(float)*(d->localRows+2*d->depth)*d->cols);
+	return 1;
+}
+
+int jacobi_domain_write(jacobi_domain* d, const char* name){
+	jacobi_block block;
+	domainBlock(d, &block);
+	if(!jacobi_io_write_block(d->comm, name, &block, d->buffer[d->current])){
+		if(d->myid == 0) printf("Error writing %s\n", name);
+		return 0;
+	}
+	return 1;
+}
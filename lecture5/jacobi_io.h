@@ -0,0 +1,75 @@
+#ifndef JACOBI_IO_H
+#define JACOBI_IO_H
+#include <stdio.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "jacobi_domain.h"
+
+/*
+ * Binary grid files, read and written by all the processes together with MPI-IO:
+ * each process sets a file view on its block (MPI_Type_create_subarray) and calls
+ * MPI_File_read_at_all/MPI_File_write_at_all, so no process ever holds the whole grid
+ * and the MPI library can merge the accesses of the processes.
+ *
+ * file format: a header of JACOBI_IO_HEADER_SIZE bytes, then the rows x cols values
+ * row after row, starting at an offset aligned to JACOBI_IO_HEADER_SIZE.
+ * the values are written in the byte order of the machine ("native" representation),
+ * the header records it so a file from another byte order is refused.
+ * the text files (jacobiInput.txt) are converted with jacobi_convert.c
+ */
+
+#define JACOBI_IO_MAGIC "JACOBIG"
+#define JACOBI_IO_VERSION 1
+#define JACOBI_IO_HEADER_SIZE 64
+/* type of the values */
+#define JACOBI_IO_FLOAT32 1
+
+typedef struct{
+	char magic[8];		/* JACOBI_IO_MAGIC */
+	int32_t version;
+	int32_t byteOrder;	/* 1 in the byte order of the writer */
+	int32_t type;		/* JACOBI_IO_FLOAT32 */
+	int32_t rows, cols;
+	int32_t reserved;
+	int64_t offset;		/* offset of the first value */
+	char padding[JACOBI_IO_HEADER_SIZE-40];
+} jacobi_io_header;
+
+/*
+ * a block of the grid owned by a process:
+ * the block (firstRow, firstCol) of localRows x localCols of the rows x cols grid,
+ * is stored at (memRow, memCol) of a local array of memRows x memCols (with the ghost cells)
+ */
+typedef struct{
+	int rows, cols;
+	int firstRow, firstCol;
+	int localRows, localCols;
+	int memRows, memCols;
+	int memRow, memCol;
+} jacobi_block;
+
+/* header of a rows x cols grid of floats */
+void jacobi_io_header_init(jacobi_io_header* header, int rows, int cols);
+/* returns 1 if the header is a valid header, with a message otherwise */
+int jacobi_io_header_check(const jacobi_io_header* header, const char* name);
+/* 1 if the name ends with .bin */
+int jacobi_io_is_binary(const char* name);
+/*
+ * the size of the grid of a binary file, read by process 0 and broadcast on comm,
+ * returns 0 if the file cannot be read
+ */
+int jacobi_io_read_size(MPI_Comm comm, const char* name, int* rows, int* cols);
+/*
+ * collective read/write of the blocks of all the processes of comm,
+ * returns 0 if the file cannot be opened or has not the size of the block
+ */
+int jacobi_io_read_block(MPI_Comm comm, const char* name, const jacobi_block* block, float* buffer);
+int jacobi_io_write_block(MPI_Comm comm, const char* name, const jacobi_block* block, float* buffer);
+/*
+ * the same for a row decomposition: the owned rows of the current grid,
+ * after a read, both grids of the domain hold the values
+ */
+int jacobi_domain_read(jacobi_domain* d, const char* name);
+int jacobi_domain_write(jacobi_domain* d, const char* name);
+
+#endif
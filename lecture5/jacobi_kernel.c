@@ -0,0 +1,226 @@
+#include <string.h>
+#include <omp.h>
+#include <mpi.h>
+#include "jacobi_kernel.h"
+
+/*
+ * Jacobi update of row i from grid to newGrid,
+ * returns the sum of the squared differences of the row.
+ * the rows do not overlap (restrict) and the loop has no dependency, so it is vectorized
+ * (the division by 4 is exact, the multiplication by 0.25 gives the same values)
+ */
+static float updateRow(jacobi_domain* d, float* grid, float* newGrid, int i){
+	int j;
+	int m = d->cols-1;
+	float diffnorm = 0.0;
+	const float* restrict up = ROW(d, grid, i-1);
+	const float* restrict row = ROW(d, grid, i);
+	const float* restrict down = ROW(d, grid, i+1);
+	float* restrict newRow = ROW(d, newGrid, i);
+	#pragma omp simd reduction(+:diffnorm)
+	for(j=1;j<m;++j){
+		float value = (up[j]+down[j]+row[j-1]+row[j+1])*0.25f;
+		float diff = value - row[j];
+		newRow[j] = value;
+		diffnorm += diff*diff;
+	}
+	return diffnorm;
+}
+
+/*
+ * the first/last rows of the whole grid are fixed
+ */
+static void clipRows(jacobi_domain* d, int* first, int* last){
+	if(d->firstRow+*first-1 < 1) *first = 2-d->firstRow;
+	if(d->firstRow+*last-1 > d->rows-2) *last = d->rows-1-d->firstRow;
+}
+
+float jacobi_sweep_rows(jacobi_domain* d, int first, int last){
+	int i;
+	float diffnorm = 0.0;
+	float* grid = jacobi_grid(d);
+	float* newGrid = jacobi_new_grid(d);
+	clipRows(d, &first, &last);
+	for(i=first;i<=last;++i){
+		diffnorm += updateRow(d, grid, newGrid, i);
+	}
+	return diffnorm;
+}
+
+float jacobi_weighted_sweep_rows(jacobi_domain* d, float* f, float omega, int first, int last){
+	int i, j;
+	int m = d->cols-1;
+	float diffnorm = 0.0;
+	float* grid = jacobi_grid(d);
+	float* newGrid = jacobi_new_grid(d);
+	clipRows(d, &first, &last);
+	for(i=first;i<=last;++i){
+		const float* restrict up = ROW(d, grid, i-1);
+		const float* restrict row = ROW(d, grid, i);
+		const float* restrict down = ROW(d, grid, i+1);
+		const float* restrict rhs = ROW(d, f, i);
+		float* restrict newRow = ROW(d, newGrid, i);
+		#pragma omp simd reduction(+:diffnorm)
+		for(j=1;j<m;++j){
+			float diff = omega*((up[j]+down[j]+row[j-1]+row[j+1]+rhs[j])*0.25f - row[j]);
+			newRow[j] = row[j] + diff;
+			diffnorm += diff*diff;
+		}
+	}
+	return diffnorm;
+}
+
+float jacobi_color_sweep_rows(jacobi_domain* d, int first, int last, int color, float omega){
+	int i, j;
+	float diffnorm = 0.0;
+	float* grid = jacobi_grid(d);
+	float *up, *row, *down;
+	float diff;
+	clipRows(d, &first, &last);
+	for(i=first;i<=last;++i){
+		up = ROW(d, grid, i-1);
+		row = ROW(d, grid, i);
+		down = ROW(d, grid, i+1);
+		/*
+		 * first column of the color in the global row firstRow+i-1
+		 */
+		j = ((d->firstRow+i-1+1)%2 == color) ? 1 : 2;
+		for(;j<d->cols-1;j+=2){
+			diff = omega*((up[j]+down[j]+row[j-1]+row[j+1])*0.25f - row[j]);
+			row[j] += diff;
+			diffnorm += diff*diff;
+		}
+	}
+	return diffnorm;
+}
+
+float jacobi_hybrid_sweep(jacobi_domain* d, double* exchangeTime){
+	int n = d->localRows;
+	int first = 2, last = n-1;
+	/* the first and last local rows, if they are not a border row of the whole grid */
+	int isTop = (d->firstRow >= 1 && d->firstRow <= d->rows-2);
+	int isBottom = (n > 1 && d->firstRow+n-1 >= 1 && d->firstRow+n-1 <= d->rows-2);
+	float diffnorm = 0.0;
+	float* grid = jacobi_grid(d);
+	float* newGrid = jacobi_new_grid(d);
+	clipRows(d, &first, &last);
+	#pragma omp parallel reduction(+:diffnorm)
+	{
+		int i;
+		/*
+		 * MPI_THREAD_FUNNELED: only the master thread calls MPI,
+		 * it joins the computation of the inner rows when the ghost rows have arrived
+		 */
+		#pragma omp master
+		{
+			double time = MPI_Wtime();
+			halo_start(d);
+			halo_finish(d);
+			*exchangeTime += MPI_Wtime()-time;
+		}
+		#pragma omp for schedule(dynamic, 4) nowait
+		for(i=first;i<=last;++i){
+			diffnorm += updateRow(d, grid, newGrid, i);
+		}
+		/*
+		 * the ghost rows are needed by the first and last rows
+		 */
+		#pragma omp barrier
+		#pragma omp single nowait
+		{
+			if(isTop) diffnorm += updateRow(d, grid, newGrid, 1);
+		}
+		#pragma omp single nowait
+		{
+			if(isBottom) diffnorm += updateRow(d, grid, newGrid, n);
+		}
+	}
+	jacobi_swap(d);
+	return diffnorm;
+}
+
+float jacobi_wavefront(jacobi_domain* d, int steps){
+	int n = d->localRows, h = d->depth;
+	int r, s, i, first, last, lastRow;
+	/* interior of the whole grid, in local rows */
+	int interiorFirst = 2-d->firstRow, interiorLast = d->rows-1-d->firstRow;
+	float diffnorm = 0.0;
+	float* buffer[2];
+	if(steps > h) steps = h;
+	buffer[0] = jacobi_grid(d);
+	buffer[1] = jacobi_new_grid(d);
+	/*
+	 * the ghost rows are only received in the current grid:
+	 * copy them to the new grid for their border columns and the fixed border rows of the whole grid
+	 */
+	if(steps > 1){
+		memcpy(ROW(d, buffer[1], 1-h), ROW(d, buffer[0], 1-h), sizeof(float)*h*d->cols);
+		memcpy(ROW(d, buffer[1], n+1), ROW(d, buffer[0], n+1), sizeof(float)*h*d->cols);
+	}
+	lastRow = n+steps-1;
+	if(lastRow > interiorLast) lastRow = interiorLast;
+	for(r=1-steps+1;r<=lastRow+2*(steps-1);++r){
+		for(s=1;s<=steps;++s){
+			i = r-2*(s-1);
+			first = 1-steps+s;
+			last = n+steps-s;
+			if(first < interiorFirst) first = interiorFirst;
+			if(last > interiorLast) last = interiorLast;
+			if(i < first || i > last) continue;
+			/*
+			 * sweep s reads buffer (s-1)%2 and writes buffer s%2
+			 */
+			if(s == steps){
+				diffnorm += updateRow(d, buffer[(s-1)%2], buffer[s%2], i);
+			}else{
+				updateRow(d, buffer[(s-1)%2], buffer[s%2], i);
+			}
+		}
+	}
+	for(s=0;s<steps;++s){
+		jacobi_swap(d);
+	}
+	return diffnorm;
+}
+
+void jacobi_laplace_rows(jacobi_domain* d, int first, int last){
+	int i, j;
+	int m = d->cols-1;
+	float* v = jacobi_grid(d);
+	float* q = jacobi_new_grid(d);
+	clipRows(d, &first, &last);
+	for(i=first;i<=last;++i){
+		const float* restrict up = ROW(d, v, i-1);
+		const float* restrict row = ROW(d, v, i);
+		const float* restrict down = ROW(d, v, i+1);
+		float* restrict result = ROW(d, q, i);
+		#pragma omp simd
+		for(j=1;j<m;++j){
+			result[j] = 4.0f*row[j] - up[j] - down[j] - row[j-1] - row[j+1];
+		}
+	}
+}
+
+void jacobi_laplace(jacobi_domain* d){
+	int n = d->localRows;
+	halo_start(d);
+	jacobi_laplace_rows(d, 2, n-1);
+	halo_finish(d);
+	jacobi_laplace_rows(d, 1, 1);
+	if(n > 1) jacobi_laplace_rows(d, n, n);
+}
+
+double jacobi_dot_rows(jacobi_domain* d, float* x, float* y){
+	int i, j;
+	int first = 1, last = d->localRows;
+	double dot = 0.0;
+	clipRows(d, &first, &last);
+	for(i=first;i<=last;++i){
+		float* xRow = ROW(d, x, i);
+		float* yRow = ROW(d, y, i);
+		for(j=1;j<d->cols-1;++j){
+			dot += xRow[j]*yRow[j];
+		}
+	}
+	return dot;
+}
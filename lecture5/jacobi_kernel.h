@@ -0,0 +1,68 @@
+#ifndef JACOBI_KERNEL_H
+#define JACOBI_KERNEL_H
+#include "jacobi_domain.h"
+
+/*
+ * Jacobi sweeps on a row decomposition (jacobi_domain.h),
+ * the border rows and columns of the whole grid are fixed.
+ */
+
+/*
+ * Jacobi update of the local rows first..last from the current grid to the new grid,
+ * the rows outside of the interior of the whole grid are skipped.
+ * returns the local sum of the squared differences
+ */
+float jacobi_sweep_rows(jacobi_domain* d, int first, int last);
+/*
+ * weighted Jacobi update of the local rows first..last for the equation 4u - (sum of the 4 neighbors) = f,
+ * from the current grid to the new grid: u + omega*((sum of the neighbors + f)/4 - u).
+ * f has the layout of the grid. with f = 0 and omega = 1, it is jacobi_sweep_rows().
+ * returns the local sum of the squared differences
+ */
+float jacobi_weighted_sweep_rows(jacobi_domain* d, float* f, float omega, int first, int last);
+/*
+ * hybrid MPI+OpenMP sweep of all the local rows, with a halo of depth 1:
+ * the master thread does the exchange (MPI_THREAD_FUNNELED) while the other threads
+ * update the rows 2..localRows-1, then the master joins them (dynamic schedule);
+ * the first and last rows are updated after a barrier.
+ * the time of the master in the exchange is added to exchangeTime.
+ * the grid is swapped after the sweep.
+ * returns the local sum of the squared differences
+ */
+float jacobi_hybrid_sweep(jacobi_domain* d, double* exchangeTime);
+/*
+ * red-black update in place of the points of one color of the local rows first..last:
+ * color 0 (red) are the points with an even global i+j, color 1 (black) the others.
+ * a point only depends on points of the other color.
+ * the point moves from its value to the Gauss-Seidel value by omega (1: Gauss-Seidel, >1: SOR).
+ * returns the local sum of the squared differences
+ */
+float jacobi_color_sweep_rows(jacobi_domain* d, int first, int last, int color, float omega);
+/*
+ * temporal blocking: steps (<= depth) sweeps after one exchange of depth ghost rows.
+ * sweep s (1..steps) is valid on the rows 1-steps+s..localRows+steps-s,
+ * the ghost region shrinks by one row on each side per sweep.
+ *
+ * the sweeps are done as a wavefront going down the rows:
+ * when sweep 1 updates row r, sweep s updates row r-2(s-1).
+ * sweep s only needs the rows r-2(s-1)-1..r-2(s-1)+1 of sweep s-1, which are already computed,
+ * and overwrites a row of sweep s-2 that sweep s-1 does not need any more,
+ * so the 2 buffers are enough and the rows of all the sweeps are reused from the cache
+ * (about 2*steps+1 rows of each buffer), instead of one pass over the grid per sweep.
+ *
+ * the grid is swapped after each sweep (the current grid is the one of the last sweep).
+ * returns the local sum of the squared differences of the last sweep
+ */
+float jacobi_wavefront(jacobi_domain* d, int steps);
+/*
+ * product q = A v of the matrix of the Laplace equation (4 on the diagonal, -1 for the neighbors)
+ * on the local rows first..last: v is the current grid (with its ghost rows), q the new grid.
+ * only the inner points of the whole grid are unknowns, the other points of q are not written
+ */
+void jacobi_laplace_rows(jacobi_domain* d, int first, int last);
+/* q = A v on all the local rows, with the exchange of the ghost rows of v overlapped with the inner rows */
+void jacobi_laplace(jacobi_domain* d);
+/* local dot product of 2 vectors with the layout of the grid, on the inner points */
+double jacobi_dot_rows(jacobi_domain* d, float* x, float* y);
+
+#endif
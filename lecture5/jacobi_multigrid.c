@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <getopt.h>
+#include <mpi.h>
+#include "jacobi_domain.h"
+#include "jacobi_kernel.h"
+#include "jacobi_convergence.h"
+#include "jacobi_io.h"
+#include "mpi_profile.h"
+
+#define THRESHOLD 0.001
+#define MAX_CYCLES 100000
+#define MAX_LEVELS 32
+/* a level is gathered on process 0 when a process would own less coarse rows */
+#define MIN_LOCAL_ROWS 2
+/* weight of the Jacobi smoother, which damps best the high frequencies of the 5 point stencil */
+#define SMOOTHER_WEIGHT 0.8
+/* the conjugate gradient of the coarsest level reduces the norm of its residual by this factor */
+#define COARSE_REDUCTION 0.001
+
+/*
+ * Geometric multigrid for the grid of the Jacobi programs:
+ * the Jacobi iteration only damps the error between neighbor points,
+ * the smooth part of the error needs a number of sweeps growing with the square of the grid size.
+ * A cycle smooths the error with a few weighted Jacobi sweeps, solves the equation of the error
+ * on a grid twice coarser (recursively), interpolates the coarse correction and smooths again.
+ *
+ * the equation of level l is 4u - (sum of the 4 neighbors) = f,
+ * f = 0 on the finest grid, whose border values are fixed;
+ * the coarse level gets 4 times the restricted residual (the mesh size doubles), with a zero border.
+ * restriction: full weighting, prolongation: bilinear interpolation.
+ * the grid is coarsened while (rows-1) and (cols-1) are even, e.g. 2^k+1 rows and columns:
+ * with an odd number of intervals, the coarse grid would not end on the border of the fine grid,
+ * the coarse correction would not vanish where the fine one does and the cycles would slow down
+ * (or diverge) with each such level, so the coarsening stops there and process 0 warns about it.
+ * the coarsest level is solved by the conjugate gradient (as in laplace_cg.c),
+ * until the norm of its residual is reduced by COARSE_REDUCTION, so the cycles converge
+ * whatever the size of the coarsest grid, at the cost of more iterations on a large one.
+ *
+ * the levels are distributed by rows (jacobi_domain.h): the coarse row I is owned by the owner
+ * of the fine row 2I, so the restriction only needs the ghost rows of the residual
+ * and the prolongation the ghost rows of the coarse correction.
+ * when a process would own less than MIN_LOCAL_ROWS coarse rows, the coarse level
+ * is gathered on process 0 and the coarser levels are solved by process 0 alone.
+ *
+ * V-cycle: one coarse cycle per level, W-cycle: two.
+ * the cycles stop when the norm of the residual divided by 4 (the difference of a Jacobi sweep)
+ * is below THRESHOLD, as for the Jacobi programs.
+ */
+
+typedef struct{
+	jacobi_domain d;	/* the correction (the solution on the finest level), and the new grid of the smoother */
+	float* f;		/* right-hand side, with the layout of the grid */
+	int active;		/* this process has the level */
+	int gathered;		/* the level is on process 0 only, the finer level is distributed */
+	/*
+	 * gathered level, on each process of the finer level:
+	 * coarse rows restricted from its fine rows, and coarse rows needed by the interpolation of its fine rows
+	 */
+	int restrictFirst, restrictCount;
+	int prolongFirst, prolongCount;
+	float* restrictBuffer;
+	float* prolongBuffer;
+	int* restrictCounts;	/* process 0: arguments of MPI_Gatherv/MPI_Scatterv */
+	int* restrictDispls;
+	int* prolongCounts;
+	int* prolongDispls;
+	float* x;		/* coarsest level: solution and residual of the conjugate gradient */
+	float* r;
+} mg_level;
+
+/*
+ * create the coarse levels below levels[0], at most maxLevels levels,
+ * returns the number of levels known by this process
+ */
+int setupLevels(mg_level* levels, int maxLevels, halo_mode mode);
+void freeLevels(mg_level* levels, int levelNumber);
+/*
+ * weighted Jacobi sweeps on a level, with the halo exchange overlapped with the inner rows
+ */
+void smooth(mg_level* level, int sweeps, float omega);
+/*
+ * residual f - 4u + (sum of the 4 neighbors) of the local rows first..last, written to r if not NULL
+ * (the ghost rows of u must be up to date), returns the local squared norm
+ */
+float residualRows(mg_level* level, float* r, int first, int last);
+/*
+ * right-hand side of the coarse level: 4 times the full weighting of the fine residual
+ */
+void restrictResidual(mg_level* fine, mg_level* coarse);
+/*
+ * adds the bilinear interpolation of the coarse correction to the fine level
+ */
+void prolongCorrection(mg_level* coarse, mg_level* fine);
+/*
+ * conjugate gradient on the coarsest level, from the current grid:
+ * p is the current grid of the domain (its ghost rows are exchanged), q = Ap the new grid,
+ * and the solution is copied back to both grids at the end
+ */
+void coarseSolve(mg_level* level);
+/*
+ * one multigrid cycle from level l, gamma coarse cycles per level (1: V-cycle, 2: W-cycle)
+ */
+void cycle(mg_level* levels, int l, int levelNumber, int gamma, int sweeps);
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int myid, int* rows, int* cols, char** inputName, char** outputName, int* mode,
+	int* maxLevels, int* gamma, int* sweeps, int* isDisplay);
+
+/*
+ * to compile:
+ * mpicc -fopenmp -o jacobi_multigrid jacobi_multigrid.c jacobi_domain.c jacobi_kernel.c jacobi_convergence.c jacobi_io.c jacobi_text.c -lm
+ * to run, V-cycles on a 1025 x 1025 grid:
+ * mpirun -np 4 ./jacobi_multigrid -r 1025 -c 1025
+ * W-cycles with 3 levels and 3 sweeps before and after the coarse correction:
+ * mpirun -np 4 ./jacobi_multigrid -r 257 -c 257 -l 3 -y w -s 3
+ */
+int main(int argc, char* argv[]){
+
+	MPI_Init(&argc, &argv);
+	mg_level levels[MAX_LEVELS];
+	jacobi_convergence convergenceCheck;
+	int rows = 129, cols = 129;
+	char* inputName = NULL;
+	char* outputName = NULL;
+	int mode = HALO_NONBLOCKING;
+	int maxLevels = MAX_LEVELS;
+	int gamma = 1;
+	int sweeps = 2;
+	int isDisplay = 0;
+	int myid, levelNumber, l, cycles = 0;
+	double startTime, elapsedTime;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	parseArgs(argc, argv, myid, &rows, &cols, &inputName, &outputName, &mode, &maxLevels, &gamma, &sweeps, &isDisplay);
+	if(inputName != NULL && jacobi_io_is_binary(inputName)){
+		if(!jacobi_io_read_size(MPI_COMM_WORLD, inputName, &rows, &cols)){
+			MPI_Finalize();
+			return 1;
+		}
+	}
+	memset(&levels[0], 0, sizeof(mg_level));
+	if(!jacobi_domain_create(&levels[0].d, MPI_COMM_WORLD, rows, cols, 1, mode)){
+		if(myid == 0) printf("Too many processes for %d rows\n", rows);
+		MPI_Finalize();
+		return 1;
+	}
+	levels[0].active = 1;
+	levels[0].f = (float*) calloc((long)(levels[0].d.localRows+2)*cols, sizeof(float));
+	if(inputName != NULL && jacobi_io_is_binary(inputName)){
+		if(!jacobi_domain_read(&levels[0].d, inputName)) MPI_Abort(MPI_COMM_WORLD, 1);
+	}else if(inputName != NULL){
+		if(!jacobi_domain_read_text(&levels[0].d, inputName)) MPI_Abort(MPI_COMM_WORLD, 1);
+	}else{
+		jacobi_domain_generate(&levels[0].d);
+	}
+	levelNumber = setupLevels(levels, maxLevels, mode);
+	if(myid == 0){
+		printf("grid %d x %d, %d processes, %s-cycles, %d sweeps before and after the coarse correction\n",
+			rows, cols, levels[0].d.numprocs, gamma == 1 ? "V" : "W", sweeps);
+		printf("level\tgrid\t\tprocesses\n");
+		for(l=0;l<levelNumber;++l){
+			printf("%d\t%d x %d\t%d%s\n", l, levels[l].d.rows, levels[l].d.cols, levels[l].d.numprocs,
+				levels[l].gathered ? " (gathered)" : "");
+		}
+	}
+
+	convergence_init(&convergenceCheck, levels[0].d.comm, THRESHOLD, 1);
+	MPI_Barrier(MPI_COMM_WORLD);
+	startTime = MPI_Wtime();
+	int convergence = 1;
+	while(convergence && cycles < MAX_CYCLES){
+		cycle(levels, 0, levelNumber, gamma, sweeps);
+		/*
+		 * checking for convergence: the residual divided by 4 is the difference of a Jacobi sweep
+		 */
+		halo_start(&levels[0].d);
+		halo_finish(&levels[0].d);
+		if(convergence_update(&convergenceCheck, cycles, residualRows(&levels[0], NULL, 1, levels[0].d.localRows)/16.0)){
+			convergence = 0;
+		}
+		++cycles;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
+	}
+	convergence_free(&convergenceCheck);
+	elapsedTime = MPI_Wtime() - startTime;
+
+	if(myid == 0){
+		printf("%d cycles, %lf (s), residual norm %f\n", cycles, elapsedTime, 4.0*convergenceCheck.norm);
+	}
+	if(isDisplay){
+		jacobi_domain_print(&levels[0].d);
+	}
+	if(outputName != NULL){
+		jacobi_domain_write(&levels[0].d, outputName);
+	}
+	freeLevels(levels, levelNumber);
+	MPI_Finalize();
+	return 0;
+}
+
+int setupLevels(mg_level* levels, int maxLevels, halo_mode mode){
+	int levelNumber = 1;
+	int fineRows, fineCols, rows, cols, lastRow, minCount, p;
+	int counts[4];
+	int* all = NULL;
+	mg_level *fine, *coarse;
+	while(levelNumber < maxLevels && levelNumber < MAX_LEVELS){
+		fine = &levels[levelNumber-1];
+		if(!fine->active) break;
+		fineRows = fine->d.rows;
+		fineCols = fine->d.cols;
+		if(fineRows < 5 || fineCols < 5) break;
+		if((fineRows-1)%2 != 0 || (fineCols-1)%2 != 0){
+			if(fine->d.myid == 0){
+				printf("Warning: the level %d (%d x %d) cannot be halved, (rows-1) and (cols-1) must be even (e.g. 2^k+1),"
+					" it is solved by the conjugate gradient\n", levelNumber-1, fineRows, fineCols);
+			}
+			break;
+		}
+		rows = (fineRows-1)/2+1;
+		cols = (fineCols-1)/2+1;
+		coarse = &levels[levelNumber];
+		memset(coarse, 0, sizeof(mg_level));
+		/*
+		 * the coarse row I is owned by the owner of the fine row 2I
+		 */
+		lastRow = fine->d.firstRow+fine->d.localRows-1;
+		coarse->restrictFirst = (fine->d.firstRow+1)/2;
+		coarse->restrictCount = lastRow/2-coarse->restrictFirst+1;
+		MPI_Allreduce(&coarse->restrictCount, &minCount, 1, MPI_INT, MPI_MIN, fine->d.comm);
+		if(fine->d.numprocs == 1 || minCount >= MIN_LOCAL_ROWS){
+			jacobi_domain_create_rows(&coarse->d, fine->d.comm, rows, cols, coarse->restrictFirst, coarse->restrictCount, 1, mode);
+			coarse->active = 1;
+		}else{
+			/*
+			 * the interpolation of the fine rows firstRow..lastRow needs the coarse rows firstRow/2..(lastRow+1)/2
+			 */
+			coarse->gathered = 1;
+			coarse->prolongFirst = fine->d.firstRow/2;
+			coarse->prolongCount = (lastRow+1)/2-coarse->prolongFirst+1;
+			coarse->restrictBuffer = (float*) malloc(sizeof(float)*(coarse->restrictCount+1)*cols);
+			coarse->prolongBuffer = (float*) malloc(sizeof(float)*coarse->prolongCount*cols);
+			counts[0] = coarse->restrictFirst;
+			counts[1] = coarse->restrictCount;
+			counts[2] = coarse->prolongFirst;
+			counts[3] = coarse->prolongCount;
+			if(fine->d.myid == 0){
+				all = (int*) malloc(sizeof(int)*4*fine->d.numprocs);
+				coarse->restrictCounts = (int*) malloc(sizeof(int)*fine->d.numprocs);
+				coarse->restrictDispls = (int*) malloc(sizeof(int)*fine->d.numprocs);
+				coarse->prolongCounts = (int*) malloc(sizeof(int)*fine->d.numprocs);
+				coarse->prolongDispls = (int*) malloc(sizeof(int)*fine->d.numprocs);
+			}
+			MPI_Gather(counts, 4, MPI_INT, all, 4, MPI_INT, 0, fine->d.comm);
+			if(fine->d.myid == 0){
+				/*
+				 * the rows of the gathered level start at row 1 of the buffer of process 0
+				 */
+				for(p=0;p<fine->d.numprocs;++p){
+					coarse->restrictDispls[p] = all[4*p]*cols;
+					coarse->restrictCounts[p] = all[4*p+1]*cols;
+					coarse->prolongDispls[p] = all[4*p+2]*cols;
+					coarse->prolongCounts[p] = all[4*p+3]*cols;
+				}
+				free(all);
+				jacobi_domain_create(&coarse->d, MPI_COMM_SELF, rows, cols, 1, mode);
+				coarse->active = 1;
+			}
+		}
+		if(coarse->active){
+			coarse->f = (float*) calloc((long)(coarse->d.localRows+2)*cols, sizeof(float));
+		}
+		++levelNumber;
+	}
+	coarse = &levels[levelNumber-1];
+	if(coarse->active){
+		coarse->x = (float*) malloc(sizeof(float)*(coarse->d.localRows+2)*coarse->d.cols);
+		coarse->r = (float*) calloc((long)(coarse->d.localRows+2)*coarse->d.cols, sizeof(float));
+	}
+	return levelNumber;
+}
+
+void freeLevels(mg_level* levels, int levelNumber){
+	int l;
+	for(l=levelNumber-1;l>=0;--l){
+		if(levels[l].active){
+			jacobi_domain_free(&levels[l].d);
+			free(levels[l].f);
+			free(levels[l].x);
+			free(levels[l].r);
+		}
+		if(levels[l].gathered){
+			free(levels[l].restrictBuffer);
+			free(levels[l].prolongBuffer);
+			free(levels[l].restrictCounts);
+			free(levels[l].restrictDispls);
+			free(levels[l].prolongCounts);
+			free(levels[l].prolongDispls);
+		}
+	}
+}
+
+void smooth(mg_level* level, int sweeps, float omega){
+	jacobi_domain* d = &level->d;
+	int n = d->localRows;
+	int s;
+	for(s=0;s<sweeps;++s){
+		halo_start(d);
+		jacobi_weighted_sweep_rows(d, level->f, omega, 2, n-1);
+		halo_finish(d);
+		jacobi_weighted_sweep_rows(d, level->f, omega, 1, 1);
+		if(n > 1) jacobi_weighted_sweep_rows(d, level->f, omega, n, n);
+		jacobi_swap(d);
+	}
+}
+
+float residualRows(mg_level* level, float* r, int first, int last){
+	jacobi_domain* d = &level->d;
+	int i, j;
+	float residual, norm = 0.0;
+	float* grid = jacobi_grid(d);
+	float *up, *row, *down, *rhs;
+	/*
+	 * the first/last rows of the whole grid are fixed
+	 */
+	if(d->firstRow+first-1 < 1) first = 2-d->firstRow;
+	if(d->firstRow+last-1 > d->rows-2) last = d->rows-1-d->firstRow;
+	for(i=first;i<=last;++i){
+		up = ROW(d, grid, i-1);
+		row = ROW(d, grid, i);
+		down = ROW(d, grid, i+1);
+		rhs = ROW(d, level->f, i);
+		for(j=1;j<d->cols-1;++j){
+			residual = rhs[j] + up[j] + down[j] + row[j-1] + row[j+1] - 4.0f*row[j];
+			if(r != NULL) ROW(d, r, i)[j] = residual;
+			norm += residual*residual;
+		}
+	}
+	return norm;
+}
+
+void restrictResidual(mg_level* fine, mg_level* coarse){
+	jacobi_domain* d = &fine->d;
+	int I, J, i, j;
+	int first, last;
+	int cols = (d->cols-1)/2+1, rows = (d->rows-1)/2+1;
+	float *r, *up, *row, *down, *target, *coarseRow;
+	/*
+	 * the residual is written to the new grid, which becomes the current grid for the exchange of its ghost rows
+	 */
+	halo_start(d);
+	halo_finish(d);
+	r = jacobi_new_grid(d);
+	residualRows(fine, r, 1, d->localRows);
+	jacobi_swap(d);
+	halo_start(d);
+	halo_finish(d);
+	jacobi_swap(d);
+	if(coarse->gathered){
+		target = coarse->restrictBuffer;
+		first = coarse->restrictFirst;
+		last = first+coarse->restrictCount-1;
+	}else{
+		target = ROW(&coarse->d, coarse->f, 1);
+		first = coarse->d.firstRow;
+		last = first+coarse->d.localRows-1;
+	}
+	for(I=first;I<=last;++I){
+		coarseRow = target+(long)(I-first)*cols;
+		memset(coarseRow, 0, sizeof(float)*cols);
+		if(I == 0 || I == rows-1) continue;
+		i = 2*I-d->firstRow+1;
+		up = ROW(d, r, i-1);
+		row = ROW(d, r, i);
+		down = ROW(d, r, i+1);
+		for(J=1;J<cols-1;++J){
+			j = 2*J;
+			coarseRow[J] = 4.0f*(4.0f*row[j] + 2.0f*(up[j]+down[j]+row[j-1]+row[j+1])
+				+ up[j-1]+up[j+1]+down[j-1]+down[j+1])/16.0f;
+		}
+	}
+	if(coarse->gathered){
+		MPI_Gatherv(coarse->restrictBuffer, coarse->restrictCount*cols, MPI_FLOAT,
+			coarse->active ? ROW(&coarse->d, coarse->f, 1) : NULL, coarse->restrictCounts, coarse->restrictDispls,
+			MPI_FLOAT, 0, d->comm);
+	}
+}
+
+void prolongCorrection(mg_level* coarse, mg_level* fine){
+	jacobi_domain* d = &fine->d;
+	int i, j, gi, a, a2, b, b2;
+	int first = 1, last = d->localRows;
+	int cols = (d->cols-1)/2+1;
+	int rowsFirst;
+	float *rowsBuffer, *row, *c, *c2;
+	if(coarse->gathered){
+		/*
+		 * the coarse rows needed by the processes overlap, MPI_Scatterv allows it
+		 */
+		MPI_Scatterv(coarse->active ? ROW(&coarse->d, jacobi_grid(&coarse->d), 1) : NULL,
+			coarse->prolongCounts, coarse->prolongDispls, MPI_FLOAT,
+			coarse->prolongBuffer, coarse->prolongCount*cols, MPI_FLOAT, 0, d->comm);
+		rowsBuffer = coarse->prolongBuffer;
+		rowsFirst = coarse->prolongFirst;
+	}else{
+		halo_start(&coarse->d);
+		halo_finish(&coarse->d);
+		rowsBuffer = ROW(&coarse->d, jacobi_grid(&coarse->d), 0);
+		rowsFirst = coarse->d.firstRow-1;
+	}
+	if(d->firstRow+first-1 < 1) first = 2-d->firstRow;
+	if(d->firstRow+last-1 > d->rows-2) last = d->rows-1-d->firstRow;
+	for(i=first;i<=last;++i){
+		gi = d->firstRow+i-1;
+		a = gi/2;
+		a2 = (gi+1)/2;
+		c = rowsBuffer+(long)(a-rowsFirst)*cols;
+		c2 = rowsBuffer+(long)(a2-rowsFirst)*cols;
+		row = ROW(d, jacobi_grid(d), i);
+		/*
+		 * for an even index, a == a2 (or b == b2) and the coarse value is taken twice
+		 */
+		for(j=1;j<d->cols-1;++j){
+			b = j/2;
+			b2 = (j+1)/2;
+			row[j] += 0.25f*(c[b]+c[b2]+c2[b]+c2[b2]);
+		}
+	}
+}
+
+void coarseSolve(mg_level* level){
+	jacobi_domain* d = &level->d;
+	long k, size = (long)(d->localRows+2)*d->cols;
+	int iterations = 0;
+	int maxIterations = (d->rows-2)*(d->cols-2);
+	float alpha, beta;
+	float *p, *q;
+	double local, rr, rrNew, pq, target;
+	/*
+	 * r = f - Ax, the points of r which are not inner points stay 0
+	 */
+	halo_start(d);
+	halo_finish(d);
+	local = residualRows(level, level->r, 1, d->localRows);
+	MPI_Allreduce(&local, &rr, 1, MPI_DOUBLE, MPI_SUM, d->comm);
+	target = COARSE_REDUCTION*COARSE_REDUCTION*rr;
+	memcpy(level->x, jacobi_grid(d), sizeof(float)*size);
+	p = jacobi_grid(d);
+	q = jacobi_new_grid(d);
+	memcpy(p, level->r, sizeof(float)*size);
+	memset(q, 0, sizeof(float)*size);
+	while(rr > target && iterations < maxIterations){
+		jacobi_laplace(d);
+		local = jacobi_dot_rows(d, p, q);
+		MPI_Allreduce(&local, &pq, 1, MPI_DOUBLE, MPI_SUM, d->comm);
+		alpha = rr/pq;
+		for(k=0;k<size;++k){
+			level->x[k] += alpha*p[k];
+			level->r[k] -= alpha*q[k];
+		}
+		local = jacobi_dot_rows(d, level->r, level->r);
+		MPI_Allreduce(&local, &rrNew, 1, MPI_DOUBLE, MPI_SUM, d->comm);
+		beta = rrNew/rr;
+		rr = rrNew;
+		for(k=0;k<size;++k){
+			p[k] = level->r[k] + beta*p[k];
+		}
+		++iterations;
+	}
+	/*
+	 * without coarse levels, x holds the border values of the finest grid, which both grids need
+	 */
+	memcpy(d->buffer[0], level->x, sizeof(float)*size);
+	memcpy(d->buffer[1], level->x, sizeof(float)*size);
+}
+
+void cycle(mg_level* levels, int l, int levelNumber, int gamma, int sweeps){
+	mg_level* level = &levels[l];
+	mg_level* coarse;
+	int k;
+	if(l == levelNumber-1){
+		coarseSolve(level);
+		return;
+	}
+	coarse = &levels[l+1];
+	smooth(level, sweeps, SMOOTHER_WEIGHT);
+	restrictResidual(level, coarse);
+	if(coarse->active){
+		/*
+		 * the coarse correction starts from 0
+		 */
+		memset(coarse->d.buffer[0], 0, sizeof(float)*(coarse->d.localRows+2)*coarse->d.cols);
+		memset(coarse->d.buffer[1], 0, sizeof(float)*(coarse->d.localRows+2)*coarse->d.cols);
+		for(k=0;k<gamma;++k){
+			cycle(levels, l+1, levelNumber, gamma, sweeps);
+		}
+	}
+	prolongCorrection(coarse, level);
+	smooth(level, sweeps, SMOOTHER_WEIGHT);
+}
+
+void parseArgs(int argc, char** argv, int myid, int* rows, int* cols, char** inputName, char** outputName, int* mode,
+	int* maxLevels, int* gamma, int* sweeps, int* isDisplay){
+	int c;
+	while((c=getopt(argc, argv, "r:c:i:o:x:l:y:s:d")) != -1){
+		switch(c){
+			case 'r':
+				*rows = atoi(optarg);
+				break;
+			case 'c':
+				*cols = atoi(optarg);
+				break;
+			case 'i':
+				*inputName = optarg;
+				break;
+			case 'o':
+				*outputName = optarg;
+				break;
+			case 'x':
+				*mode = halo_mode_parse(optarg);
+				if(*mode < 0){
+					if(myid == 0) printf("Unknown halo mode %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				break;
+			case 'l':
+				*maxLevels = atoi(optarg);
+				break;
+			case 'y':
+				if(strcmp(optarg, "v") == 0 || strcmp(optarg, "V") == 0){
+					*gamma = 1;
+				}else if(strcmp(optarg, "w") == 0 || strcmp(optarg, "W") == 0){
+					*gamma = 2;
+				}else{
+					if(myid == 0) printf("Unknown cycle %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				break;
+			case 's':
+				*sweeps = atoi(optarg);
+				break;
+			case 'd':
+				*isDisplay = 1;
+				break;
+			default:
+				if(myid == 0) printf("usage: %s [-r rows] [-c cols] [-i input] [-o output.bin] [-x blocking|ordered|nonblocking|persistent|neighbor] [-l levels] [-y v|w] [-s sweeps] [-d]\n", argv[0]);
+				MPI_Finalize();
+				exit(1);
+		}
+	}
+	if(*rows < 3 || *cols < 3 || *maxLevels < 1 || *sweeps < 1){
+		if(myid == 0) printf("The grid must have at least 3 rows and 3 columns, the levels and the sweeps must be positive\n");
+		MPI_Finalize();
+		exit(1);
+	}
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jacobi_text.h"
+
+int jacobi_text_open(jacobi_text_reader* reader, const char* name){
+	reader->file = fopen(name, "r");
+	if(reader->file == NULL) return 0;
+	reader->buffer = (char*) malloc(JACOBI_TEXT_BUFFER+1);
+	reader->length = reader->position = 0;
+	reader->buffer[0] = '\0';
+	return 1;
+}
+
+/*
+ * the rest of the buffer moves to the front, and the buffer is filled from the file
+ */
+static void textRefill(jacobi_text_reader* reader){
+	size_t rest = reader->length-reader->position;
+	memmove(reader->buffer, reader->buffer+reader->position, rest);
+	reader->length = rest+fread(reader->buffer+rest, 1, JACOBI_TEXT_BUFFER-rest, reader->file);
+	reader->position = 0;
+	reader->buffer[reader->length] = '\0';
+}
+
+static int textBlank(char c){
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+int jacobi_text_next(jacobi_text_reader* reader, float* value){
+	size_t end;
+	char* next;
+	for(;;){
+		while(reader->position < reader->length && textBlank(reader->buffer[reader->position])) ++reader->position;
+		if(reader->position < reader->length) break;
+		textRefill(reader);
+		if(reader->length == 0) return 0;
+	}
+	/*
+	 * a value cut by the end of the buffer is read again after the refill
+	 */
+	end = reader->position;
+	while(end < reader->length && !textBlank(reader->buffer[end])) ++end;
+	if(end == reader->length && reader->position > 0 && !feof(reader->file)) textRefill(reader);
+	*value = strtof(reader->buffer+reader->position, &next);
+	if(next == reader->buffer+reader->position) return 0;
+	reader->position = next-reader->buffer;
+	return 1;
+}
+
+void jacobi_text_close(jacobi_text_reader* reader){
+	fclose(reader->file);
+	free(reader->buffer);
+}
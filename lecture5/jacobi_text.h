@@ -0,0 +1,24 @@
+#ifndef JACOBI_TEXT_H
+#define JACOBI_TEXT_H
+#include <stdio.h>
+
+/*
+ * Text grid files (jacobiInput.txt): the file is read in blocks of JACOBI_TEXT_BUFFER bytes
+ * and the values parsed with strtof, instead of a call to fscanf("%f") per value
+ */
+
+#define JACOBI_TEXT_BUFFER 65536
+
+typedef struct{
+	FILE* file;
+	char* buffer;		/* JACOBI_TEXT_BUFFER+1 bytes */
+	size_t length, position;
+} jacobi_text_reader;
+
+/* returns 0 if the text file cannot be opened */
+int jacobi_text_open(jacobi_text_reader* reader, const char* name);
+/* the next value of the text file, returns 0 at the end of the file or if it is not a number, as fscanf */
+int jacobi_text_next(jacobi_text_reader* reader, float* value);
+void jacobi_text_close(jacobi_text_reader* reader);
+
+#endif
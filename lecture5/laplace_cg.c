@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <getopt.h>
+#include <mpi.h>
+#include "jacobi_domain.h"
+#include "jacobi_kernel.h"
+#include "jacobi_convergence.h"
+#include "jacobi_io.h"
+#include "mpi_profile.h"
+
+#define THRESHOLD 0.001
+#define MAX_ITERATIONS 1000000
+/* iterations of the pipelined conjugate gradient between two replacements of the residual */
+#define REPLACEMENT_INTERVAL 50
+
+/*
+ * Conjugate gradient for the grid of the Jacobi programs:
+ * the inner values u solve the Laplace equation 4u(i,j) - u(i-1,j) - u(i+1,j) - u(i,j-1) - u(i,j+1) = 0,
+ * with the border values fixed. The matrix A (4 on the diagonal, -1 for the neighbors) is symmetric
+ * positive definite and is never stored: A p is the 5 point stencil on the rows of the domain
+ * (jacobi_domain.h), after the exchange of the ghost rows of p, overlapped with the inner rows.
+ *
+ * cg: the standard algorithm, 2 global reductions per iteration (p.Ap, then r.z and r.r),
+ * each one waits for all the processes.
+ * pipecg: pipelined conjugate gradient (Ghysels and Vanroose): the 3 dot products of an iteration
+ * are reduced together with one MPI_Iallreduce, overlapped with the product of the matrix
+ * and the exchange of its ghost rows; it needs 4 more vectors and is a little less stable:
+ * in single precision the recurrences drift away from the true residual, so every REPLACEMENT_INTERVAL
+ * iterations the vectors are computed again from x and p (4 more products of the matrix).
+ *
+ * with -p, the Jacobi preconditioner z = r/4 (the diagonal of A) is applied;
+ * the diagonal is constant, so it only scales the vectors and the iterations are the same.
+ *
+ * all the methods stop when the norm of the residual divided by 4 (the difference of a Jacobi sweep)
+ * is below THRESHOLD, and the Jacobi iteration is run for the comparison.
+ */
+
+/* the methods */
+typedef enum{
+	METHOD_JACOBI = 0,
+	METHOD_CG,
+	METHOD_PIPELINED_CG,
+	METHODS
+} cg_method;
+
+static const char* methodNames[METHODS] = {"jacobi", "cg", "pipecg"};
+
+/* result of a method */
+typedef struct{
+	int iterations;
+	double time;		/* time to solution */
+	int reductions;		/* number of global reductions */
+	double residual;	/* norm of the last residual */
+} cg_result;
+
+/* a vector with the layout of the grid of the domain, set to 0 */
+float* newVector(jacobi_domain* d);
+/*
+ * residual r = b - Ax of the initial values (the current grid, with its border),
+ * x gets a copy of the grid and the 2 grids of the domain are set to 0 (for the vectors of the method)
+ */
+void initialResidual(jacobi_domain* d, float* x, float* r);
+/* product = A v, with v copied in the current grid of the domain */
+void multiply(jacobi_domain* d, float* v, float* product);
+/*
+ * residual replacement of the pipelined conjugate gradient:
+ * r = b - Ax, u = M^-1 r, w = Au, s = Ap, q = M^-1 s, z = Aq
+ */
+void replaceResidual(jacobi_domain* d, float scale, float* x, float* r, float* u, float* w,
+	float* p, float* s, float* q, float* z);
+/* the solvers, the solution is left in the current grid of the domain */
+void solveJacobi(jacobi_domain* d, cg_result* result);
+void solveCG(jacobi_domain* d, int usePreconditioner, cg_result* result);
+void solvePipelinedCG(jacobi_domain* d, int usePreconditioner, cg_result* result);
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int myid, int* rows, int* cols, char** inputName, char** outputName, int* mode,
+	int* method, int* usePreconditioner, int* isDisplay);
+
+/*
+ * to compile:
+ * mpicc -fopenmp -o laplace_cg laplace_cg.c jacobi_domain.c jacobi_kernel.c jacobi_convergence.c jacobi_io.c jacobi_text.c -lm
+ * to run, compare Jacobi and the 2 conjugate gradients on a 512 x 512 grid:
+ * mpirun -np 4 ./laplace_cg -r 512 -c 512
+ * pipelined conjugate gradient on the input file:
+ * mpirun -np 4 ./laplace_cg -i jacobiInput.txt -m pipecg -d
+ */
+int main(int argc, char* argv[]){
+
+	MPI_Init(&argc, &argv);
+	jacobi_domain d;
+	cg_result result;
+	int rows = 16, cols = 16;
+	char* inputName = NULL;
+	char* outputName = NULL;
+	int mode = HALO_NONBLOCKING;
+	int selectedMethod = -1;	/* -1: all the methods */
+	int usePreconditioner = 0;
+	int isDisplay = 0;
+	int myid, method;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	parseArgs(argc, argv, myid, &rows, &cols, &inputName, &outputName, &mode, &selectedMethod, &usePreconditioner, &isDisplay);
+	if(inputName != NULL && jacobi_io_is_binary(inputName)){
+		if(!jacobi_io_read_size(MPI_COMM_WORLD, inputName, &rows, &cols)){
+			MPI_Finalize();
+			return 1;
+		}
+	}
+	if(myid == 0){
+		printf("grid %d x %d, halo exchange %s%s\n", rows, cols, halo_mode_name(mode),
+			usePreconditioner ? ", Jacobi preconditioner" : "");
+		printf("method\titerations\ttime (s)\treductions\tresidual\n");
+	}
+	for(method=0;method<METHODS;++method){
+		if(selectedMethod >= 0 && method != selectedMethod) continue;
+		if(!jacobi_domain_create(&d, MPI_COMM_WORLD, rows, cols, 1, mode)){
+			if(myid == 0) printf("Too many processes for %d rows\n", rows);
+			MPI_Finalize();
+			return 1;
+		}
+		if(inputName != NULL && jacobi_io_is_binary(inputName)){
+			if(!jacobi_domain_read(&d, inputName)) MPI_Abort(MPI_COMM_WORLD, 1);
+		}else if(inputName != NULL){
+			if(!jacobi_domain_read_text(&d, inputName)) MPI_Abort(MPI_COMM_WORLD, 1);
+		}else{
+			jacobi_domain_generate(&d);
+		}
+		if(method == METHOD_JACOBI){
+			solveJacobi(&d, &result);
+		}else if(method == METHOD_CG){
+			solveCG(&d, usePreconditioner, &result);
+		}else{
+			solvePipelinedCG(&d, usePreconditioner, &result);
+		}
+		if(myid == 0){
+			printf("%s\t%d\t\t%lf\t%d\t\t%f\n", methodNames[method], result.iterations, result.time,
+				result.reductions, result.residual);
+		}
+		if(isDisplay){
+			jacobi_domain_print(&d);
+		}
+		if(outputName != NULL){
+			jacobi_domain_write(&d, outputName);
+		}
+		jacobi_domain_free(&d);
+	}
+	MPI_Finalize();
+	return 0;
+}
+
+float* newVector(jacobi_domain* d){
+	float* v = (float*) calloc((long)(d->localRows+2)*d->cols, sizeof(float));
+	if(v == NULL){
+		printf("Process %d: cannot allocate a vector\n", d->myid);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	return v;
+}
+
+void initialResidual(jacobi_domain* d, float* x, float* r){
+	long i, size = (long)(d->localRows+2)*d->cols;
+	float* q = jacobi_new_grid(d);
+	/*
+	 * with the border values in the grid, A applied to the grid is -r on the inner points,
+	 * the other points of the product stay 0
+	 */
+	memset(q, 0, sizeof(float)*size);
+	jacobi_laplace(d);
+	for(i=0;i<size;++i){
+		r[i] = -q[i];
+	}
+	memcpy(x, jacobi_grid(d), sizeof(float)*size);
+	memset(d->buffer[0], 0, sizeof(float)*size);
+	memset(d->buffer[1], 0, sizeof(float)*size);
+}
+
+void multiply(jacobi_domain* d, float* v, float* product){
+	long size = (long)(d->localRows+2)*d->cols;
+	memcpy(jacobi_grid(d), v, sizeof(float)*size);
+	jacobi_laplace(d);
+	memcpy(product, jacobi_new_grid(d), sizeof(float)*size);
+}
+
+void replaceResidual(jacobi_domain* d, float scale, float* x, float* r, float* u, float* w,
+	float* p, float* s, float* q, float* z){
+	long k, size = (long)(d->localRows+2)*d->cols;
+	/*
+	 * x holds the border values, so Ax is -r on the inner points
+	 */
+	multiply(d, x, r);
+	for(k=0;k<size;++k){
+		r[k] = -r[k];
+		u[k] = scale*r[k];
+	}
+	multiply(d, u, w);
+	multiply(d, p, s);
+	for(k=0;k<size;++k){
+		q[k] = scale*s[k];
+	}
+	multiply(d, q, z);
+}
+
+void solveJacobi(jacobi_domain* d, cg_result* result){
+	int n = d->localRows;
+	int iterations = 0;
+	float diffnorm;
+	double startTime;
+	jacobi_convergence convergenceCheck;
+
+	convergence_init(&convergenceCheck, d->comm, THRESHOLD, 1);
+	MPI_Barrier(d->comm);
+	startTime = MPI_Wtime();
+	int convergence = 1;
+	while(convergence && iterations < MAX_ITERATIONS){
+		halo_start(d);
+		diffnorm = jacobi_sweep_rows(d, 2, n-1);
+		halo_finish(d);
+		diffnorm += jacobi_sweep_rows(d, 1, 1);
+		if(n > 1) diffnorm += jacobi_sweep_rows(d, n, n);
+		jacobi_swap(d);
+		if(convergence_update(&convergenceCheck, iterations, diffnorm)){
+			convergence = 0;
+		}
+		++iterations;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
+	}
+	convergence_free(&convergenceCheck);
+	result->time = MPI_Wtime()-startTime;
+	result->iterations = iterations;
+	result->reductions = convergenceCheck.checks;
+	result->residual = 4.0*convergenceCheck.norm;
+}
+
+void solveCG(jacobi_domain* d, int usePreconditioner, cg_result* result){
+	long k, size = (long)(d->localRows+2)*d->cols;
+	int iterations = 0, reductions = 0;
+	float scale = usePreconditioner ? 0.25f : 1.0f;
+	float alpha, beta;
+	double local[2], global[2], rz, pq;
+	double startTime;
+	float* x = newVector(d);
+	float* r = newVector(d);
+	float *p, *q;
+
+	MPI_Barrier(d->comm);
+	startTime = MPI_Wtime();
+	initialResidual(d, x, r);
+	/*
+	 * p is the current grid of the domain (its ghost rows are exchanged), q = Ap the new grid
+	 */
+	p = jacobi_grid(d);
+	q = jacobi_new_grid(d);
+	for(k=0;k<size;++k){
+		p[k] = scale*r[k];
+	}
+	local[0] = jacobi_dot_rows(d, r, p);
+	local[1] = jacobi_dot_rows(d, r, r);
+	MPI_Allreduce(local, global, 2, MPI_DOUBLE, MPI_SUM, d->comm);
+	++reductions;
+	rz = global[0];
+	while(sqrt(global[1])/4.0 >= THRESHOLD && iterations < MAX_ITERATIONS){
+		jacobi_laplace(d);
+		local[0] = jacobi_dot_rows(d, p, q);
+		MPI_Allreduce(local, &pq, 1, MPI_DOUBLE, MPI_SUM, d->comm);
+		alpha = rz/pq;
+		for(k=0;k<size;++k){
+			x[k] += alpha*p[k];
+			r[k] -= alpha*q[k];
+		}
+		/*
+		 * z = M^-1 r is only a scaling of r
+		 */
+		local[1] = jacobi_dot_rows(d, r, r);
+		local[0] = scale*local[1];
+		MPI_Allreduce(local, global, 2, MPI_DOUBLE, MPI_SUM, d->comm);
+		reductions += 2;
+		beta = global[0]/rz;
+		rz = global[0];
+		for(k=0;k<size;++k){
+			p[k] = scale*r[k] + beta*p[k];
+		}
+		++iterations;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
+	}
+	/*
+	 * the solution becomes the current grid
+	 */
+	memcpy(jacobi_grid(d), x, sizeof(float)*size);
+	result->time = MPI_Wtime()-startTime;
+	result->iterations = iterations;
+	result->reductions = reductions;
+	result->residual = sqrt(global[1]);
+	free(x);
+	free(r);
+}
+
+void solvePipelinedCG(jacobi_domain* d, int usePreconditioner, cg_result* result){
+	long k, size = (long)(d->localRows+2)*d->cols;
+	int iterations = 0, reductions = 0;
+	float scale = usePreconditioner ? 0.25f : 1.0f;
+	float alpha = 1.0, alphaOld = 1.0, beta = 0.0;
+	double local[3], global[3], gamma, gammaOld = 1.0, delta;
+	double startTime;
+	MPI_Request request;
+	float* x = newVector(d);
+	float* r = newVector(d);
+	float* u = newVector(d);
+	float* w = newVector(d);
+	float* z = newVector(d);
+	float* q = newVector(d);
+	float* s = newVector(d);
+	float* p = newVector(d);
+	float *m, *n;
+
+	MPI_Barrier(d->comm);
+	startTime = MPI_Wtime();
+	initialResidual(d, x, r);
+	/*
+	 * the vector multiplied by A is the current grid of the domain, the product the new grid
+	 */
+	m = jacobi_grid(d);
+	n = jacobi_new_grid(d);
+	for(k=0;k<size;++k){
+		u[k] = scale*r[k];
+		m[k] = u[k];
+	}
+	jacobi_laplace(d);
+	memcpy(w, n, sizeof(float)*size);
+	while(iterations < MAX_ITERATIONS){
+		if(iterations > 0 && iterations%REPLACEMENT_INTERVAL == 0){
+			replaceResidual(d, scale, x, r, u, w, p, s, q, z);
+		}
+		local[0] = jacobi_dot_rows(d, r, u);
+		local[1] = jacobi_dot_rows(d, w, u);
+		local[2] = jacobi_dot_rows(d, r, r);
+		MPI_Iallreduce(local, global, 3, MPI_DOUBLE, MPI_SUM, d->comm, &request);
+		++reductions;
+		/*
+		 * m = M^-1 w and n = Am while the dot products are reduced
+		 */
+		for(k=0;k<size;++k){
+			m[k] = scale*w[k];
+		}
+		jacobi_laplace(d);
+		MPI_Wait(&request, MPI_STATUS_IGNORE);
+		gamma = global[0];
+		delta = global[1];
+		if(sqrt(global[2])/4.0 < THRESHOLD) break;
+		if(iterations > 0){
+			beta = gamma/gammaOld;
+			alpha = gamma/(delta-beta*gamma/alphaOld);
+		}else{
+			beta = 0.0;
+			alpha = gamma/delta;
+		}
+		for(k=0;k<size;++k){
+			z[k] = n[k] + beta*z[k];
+			q[k] = m[k] + beta*q[k];
+			s[k] = w[k] + beta*s[k];
+			p[k] = u[k] + beta*p[k];
+			x[k] += alpha*p[k];
+			r[k] -= alpha*s[k];
+			u[k] -= alpha*q[k];
+			w[k] -= alpha*z[k];
+		}
+		gammaOld = gamma;
+		alphaOld = alpha;
+		++iterations;
+		MPI_Pcontrol(MPI_PROFILE_ITERATION);
+	}
+	memcpy(jacobi_grid(d), x, sizeof(float)*size);
+	result->time = MPI_Wtime()-startTime;
+	result->iterations = iterations;
+	result->reductions = reductions;
+	result->residual = sqrt(global[2]);
+	free(x);
+	free(r);
+	free(u);
+	free(w);
+	free(z);
+	free(q);
+	free(s);
+	free(p);
+}
+
+void parseArgs(int argc, char** argv, int myid, int* rows, int* cols, char** inputName, char** outputName, int* mode,
+	int* method, int* usePreconditioner, int* isDisplay){
+	int c;
+	while((c=getopt(argc, argv, "r:c:i:o:x:m:pd")) != -1){
+		switch(c){
+			case 'r':
+				*rows = atoi(optarg);
+				break;
+			case 'c':
+				*cols = atoi(optarg);
+				break;
+			case 'i':
+				*inputName = optarg;
+				break;
+			case 'o':
+				*outputName = optarg;
+				break;
+			case 'x':
+				*mode = halo_mode_parse(optarg);
+				if(*mode < 0){
+					if(myid == 0) printf("Unknown halo mode %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				break;
+			case 'm':
+				for(*method=METHODS-1;*method>=0;--*method){
+					if(strcmp(optarg, methodNames[*method]) == 0) break;
+				}
+				if(*method < 0 && strcmp(optarg, "all") != 0){
+					if(myid == 0) printf("Unknown method %s\n", optarg);
+					MPI_Finalize();
+					exit(1);
+				}
+				break;
+			case 'p':
+				*usePreconditioner = 1;
+				break;
+			case 'd':
+				*isDisplay = 1;
+				break;
+			default:
+				if(myid == 0) printf("usage: %s [-r rows] [-c cols] [-i input] [-o output.bin] [-x blocking|ordered|nonblocking|persistent|neighbor] [-m jacobi|cg|pipecg|all] [-p] [-d]\n", argv[0]);
+				MPI_Finalize();
+				exit(1);
+		}
+	}
+	if(*rows < 3 || *cols < 3){
+		if(myid == 0) printf("The grid must have at least 3 rows and 3 columns\n");
+		MPI_Finalize();
+		exit(1);
+	}
+}
@@ -0,0 +1,481 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "mpi_profile.h"
+
+/*
+ * PMPI interposition library, see mpi_profile.h.
+ * every wrapper measures the time of the PMPI call and records it with the bytes of the call:
+ * the message for the point to point calls (0 for MPI_PROC_NULL), the block of the process for the collectives.
+ * the non-blocking calls record their bytes when they are posted, and the time spent waiting
+ * for them is the time of MPI_Wait/MPI_Waitall: a good overlap shows a small wait time.
+ */
+
+/* the recorded MPI functions */
+typedef enum{
+	PROFILE_SEND = 0,
+	PROFILE_RECV,
+	PROFILE_SENDRECV,
+	PROFILE_ISEND,
+	PROFILE_IRECV,
+	PROFILE_START,
+	PROFILE_WAIT,
+	PROFILE_WAITALL,
+	PROFILE_BARRIER,
+	PROFILE_BCAST,
+	PROFILE_REDUCE,
+	PROFILE_ALLREDUCE,
+	PROFILE_IALLREDUCE,
+	PROFILE_SCATTER,
+	PROFILE_SCATTERV,
+	PROFILE_GATHER,
+	PROFILE_GATHERV,
+	PROFILE_ALLGATHER,
+	PROFILE_ALLGATHERV,
+	PROFILE_IALLGATHERV,
+	PROFILE_NEIGHBOR_ALLTOALLW,
+	PROFILE_INEIGHBOR_ALLTOALLW,
+	PROFILE_FILE_READ_AT_ALL,
+	PROFILE_FILE_WRITE_AT_ALL,
+	PROFILE_CALLS
+} profile_call;
+
+static const char* callNames[PROFILE_CALLS] = {
+	"MPI_Send", "MPI_Recv", "MPI_Sendrecv", "MPI_Isend", "MPI_Irecv", "MPI_Start(all)", "MPI_Wait", "MPI_Waitall",
+	"MPI_Barrier", "MPI_Bcast", "MPI_Reduce", "MPI_Allreduce", "MPI_Iallreduce", "MPI_Scatter", "MPI_Scatterv",
+	"MPI_Gather", "MPI_Gatherv", "MPI_Allgather", "MPI_Allgatherv", "MPI_Iallgatherv",
+	"MPI_Neighbor_alltoallw", "MPI_Ineighbor_alltoallw", "MPI_File_read_at_all", "MPI_File_write_at_all"
+};
+
+/* the records of a function */
+typedef struct{
+	double calls;
+	double bytes;
+	double time;
+} profile_record;
+
+/* the values sent to process 0 at MPI_Finalize: the records, then the summary of the process */
+#define PROFILE_SUMMARY 5
+#define PROFILE_VALUES (3*PROFILE_CALLS+PROFILE_SUMMARY)
+
+/* persistent requests and their bytes, counted at each start */
+#define MAX_PERSISTENT 256
+typedef struct{
+	MPI_Request request;
+	long long bytes;
+} profile_persistent;
+
+static profile_record records[PROFILE_CALLS];
+static profile_persistent persistent[MAX_PERSISTENT];
+static int persistentCount = 0;
+static int enabled = 1;
+static double initTime = 0.0;
+static double mpiTime = 0.0;	/* time in all the recorded calls */
+/* iteration marks: the time and the MPI time at the first and the last mark */
+static long marks = 0;
+static double firstMark, lastMark, firstMarkMpi, lastMarkMpi;
+
+/* bytes of count elements of datatype */
+static long long typeBytes(int count, MPI_Datatype datatype){
+	int size = 0;
+	if(datatype == MPI_DATATYPE_NULL || count <= 0) return 0;
+	PMPI_Type_size(datatype, &size);
+	return (long long) count*size;
+}
+
+/* records a call started at startTime */
+static void record(profile_call call, long long bytes, double startTime){
+	double time = PMPI_Wtime()-startTime;
+	if(!enabled) return;
+	records[call].calls += 1.0;
+	records[call].bytes += (double) bytes;
+	records[call].time += time;
+	mpiTime += time;
+}
+
+/*
+ * bytes a process sends to its neighbors in a topology: the neighbors of a Cartesian topology are
+ * the ranks below and above in each dimension, MPI_PROC_NULL on a non periodic border, which are not
+ * counted, as for the point to point calls
+ */
+static long long neighborBytes(const int counts[], const MPI_Datatype types[], MPI_Comm comm){
+	int topology, ndims, rank, in, out, weighted, d, i;
+	int neighbors[2];
+	long long bytes = 0;
+	PMPI_Topo_test(comm, &topology);
+	if(topology == MPI_CART){
+		PMPI_Cartdim_get(comm, &ndims);
+		for(d=0;d<ndims;++d){
+			PMPI_Cart_shift(comm, d, 1, &neighbors[0], &neighbors[1]);
+			for(i=0;i<2;++i){
+				if(neighbors[i] != MPI_PROC_NULL) bytes += typeBytes(counts[2*d+i], types[2*d+i]);
+			}
+		}
+		return bytes;
+	}
+	out = 0;
+	if(topology == MPI_GRAPH){
+		PMPI_Comm_rank(comm, &rank);
+		PMPI_Graph_neighbors_count(comm, rank, &out);
+	}else if(topology == MPI_DIST_GRAPH){
+		PMPI_Dist_graph_neighbors_count(comm, &in, &out, &weighted);
+	}
+	for(i=0;i<out;++i){
+		bytes += typeBytes(counts[i], types[i]);
+	}
+	return bytes;
+}
+
+static void addPersistent(MPI_Request request, long long bytes){
+	if(persistentCount < MAX_PERSISTENT){
+		persistent[persistentCount].request = request;
+		persistent[persistentCount].bytes = bytes;
+		++persistentCount;
+	}
+}
+
+static long long persistentBytes(MPI_Request request){
+	int i;
+	for(i=0;i<persistentCount;++i){
+		if(persistent[i].request == request) return persistent[i].bytes;
+	}
+	return 0;
+}
+
+/*
+ * process 0 gathers the values of all the processes and prints the report
+ */
+static void report(void){
+	int myid, numprocs, p, c;
+	double values[PROFILE_VALUES];
+	double* all = NULL;
+	double endTime = PMPI_Wtime();
+
+	PMPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	PMPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+	for(c=0;c<PROFILE_CALLS;++c){
+		values[3*c] = records[c].calls;
+		values[3*c+1] = records[c].bytes;
+		values[3*c+2] = records[c].time;
+	}
+	values[3*PROFILE_CALLS] = endTime-initTime;
+	values[3*PROFILE_CALLS+1] = mpiTime;
+	/*
+	 * per iteration: the time between the first and the last mark, without the MPI time.
+	 * a mark ends an iteration, so n marks time the n-1 iterations after the first one
+	 */
+	values[3*PROFILE_CALLS+2] = marks > 1 ? (double) (marks-1) : 0.0;
+	values[3*PROFILE_CALLS+3] = marks > 1 ? (lastMark-firstMark)-(lastMarkMpi-firstMarkMpi) : 0.0;
+	values[3*PROFILE_CALLS+4] = marks > 1 ? lastMarkMpi-firstMarkMpi : 0.0;
+	if(myid == 0){
+		all = (double*) malloc(sizeof(double)*PROFILE_VALUES*numprocs);
+	}
+	PMPI_Gather(values, PROFILE_VALUES, MPI_DOUBLE, all, PROFILE_VALUES, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	if(myid != 0) return;
+
+	printf("\nMPI profile, %d processes\n", numprocs);
+	printf("process\ttime (s)\tMPI (s)\t\tMPI (%%)\ttimed iterations\tcompute/iteration (us)\tMPI/iteration (us)\n");
+	for(p=0;p<numprocs;++p){
+		double* v = all+p*PROFILE_VALUES+3*PROFILE_CALLS;
+		printf("%d\t%f\t%f\t%.1f\t", p, v[0], v[1], v[0] > 0.0 ? 100.0*v[1]/v[0] : 0.0);
+		if(v[2] > 0.0){
+			printf("%ld\t\t\t%f\t\t%f\n", (long) v[2], 1e6*v[3]/v[2], 1e6*v[4]/v[2]);
+		}else{
+			printf("-\t\t\t-\t\t\t-\n");
+		}
+	}
+	printf("function\t\tcalls\t\tbytes\t\ttime min (s)\ttime avg (s)\ttime max (s)\n");
+	for(c=0;c<PROFILE_CALLS;++c){
+		double calls = 0.0, bytes = 0.0, sum = 0.0;
+		double min = all[3*c+2], max = all[3*c+2];
+		for(p=0;p<numprocs;++p){
+			double* v = all+p*PROFILE_VALUES+3*c;
+			calls += v[0];
+			bytes += v[1];
+			sum += v[2];
+			if(v[2] < min) min = v[2];
+			if(v[2] > max) max = v[2];
+		}
+		if(calls == 0.0) continue;
+		printf("%-22s\t%.0f\t\t%.0f\t\t%f\t%f\t%f\n", callNames[c], calls, bytes, min, sum/numprocs, max);
+	}
+	free(all);
+}
+
+int MPI_Init(int* argc, char*** argv){
+	int error = PMPI_Init(argc, argv);
+	initTime = PMPI_Wtime();
+	return error;
+}
+
+int MPI_Init_thread(int* argc, char*** argv, int required, int* provided){
+	int error = PMPI_Init_thread(argc, argv, required, provided);
+	initTime = PMPI_Wtime();
+	return error;
+}
+
+int MPI_Finalize(void){
+	report();
+	return PMPI_Finalize();
+}
+
+int MPI_Pcontrol(const int level, ...){
+	double time;
+	switch(level){
+		case MPI_PROFILE_OFF:
+			enabled = 0;
+			break;
+		case MPI_PROFILE_ON:
+			enabled = 1;
+			break;
+		case MPI_PROFILE_ITERATION:
+			time = PMPI_Wtime();
+			if(marks == 0){
+				firstMark = time;
+				firstMarkMpi = mpiTime;
+			}
+			lastMark = time;
+			lastMarkMpi = mpiTime;
+			++marks;
+			break;
+	}
+	return MPI_SUCCESS;
+}
+
+int MPI_Send(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Send(buf, count, datatype, dest, tag, comm);
+	record(PROFILE_SEND, dest == MPI_PROC_NULL ? 0 : typeBytes(count, datatype), time);
+	return error;
+}
+
+int MPI_Recv(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Status* status){
+	MPI_Status localStatus;
+	int received;
+	double time = PMPI_Wtime();
+	int error;
+	if(status == MPI_STATUS_IGNORE) status = &localStatus;
+	error = PMPI_Recv(buf, count, datatype, source, tag, comm, status);
+	/*
+	 * the bytes actually received
+	 */
+	if(error != MPI_SUCCESS || PMPI_Get_count(status, datatype, &received) != MPI_SUCCESS || received == MPI_UNDEFINED){
+		received = count;
+	}
+	record(PROFILE_RECV, typeBytes(received, datatype), time);
+	return error;
+}
+
+int MPI_Sendrecv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, int dest, int sendtag,
+	void* recvbuf, int recvcount, MPI_Datatype recvtype, int source, int recvtag, MPI_Comm comm, MPI_Status* status){
+	double time = PMPI_Wtime();
+	int error = PMPI_Sendrecv(sendbuf, sendcount, sendtype, dest, sendtag, recvbuf, recvcount, recvtype,
+		source, recvtag, comm, status);
+	record(PROFILE_SENDRECV, (dest == MPI_PROC_NULL ? 0 : typeBytes(sendcount, sendtype))
+		+(source == MPI_PROC_NULL ? 0 : typeBytes(recvcount, recvtype)), time);
+	return error;
+}
+
+int MPI_Isend(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm, MPI_Request* request){
+	double time = PMPI_Wtime();
+	int error = PMPI_Isend(buf, count, datatype, dest, tag, comm, request);
+	record(PROFILE_ISEND, dest == MPI_PROC_NULL ? 0 : typeBytes(count, datatype), time);
+	return error;
+}
+
+int MPI_Irecv(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Request* request){
+	double time = PMPI_Wtime();
+	int error = PMPI_Irecv(buf, count, datatype, source, tag, comm, request);
+	record(PROFILE_IRECV, source == MPI_PROC_NULL ? 0 : typeBytes(count, datatype), time);
+	return error;
+}
+
+int MPI_Send_init(const void* buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm,
+	MPI_Request* request){
+	int error = PMPI_Send_init(buf, count, datatype, dest, tag, comm, request);
+	addPersistent(*request, dest == MPI_PROC_NULL ? 0 : typeBytes(count, datatype));
+	return error;
+}
+
+int MPI_Recv_init(void* buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm,
+	MPI_Request* request){
+	int error = PMPI_Recv_init(buf, count, datatype, source, tag, comm, request);
+	addPersistent(*request, source == MPI_PROC_NULL ? 0 : typeBytes(count, datatype));
+	return error;
+}
+
+int MPI_Request_free(MPI_Request* request){
+	int i;
+	for(i=0;i<persistentCount;++i){
+		if(persistent[i].request == *request){
+			persistent[i] = persistent[--persistentCount];
+			break;
+		}
+	}
+	return PMPI_Request_free(request);
+}
+
+int MPI_Start(MPI_Request* request){
+	long long bytes = persistentBytes(*request);
+	double time = PMPI_Wtime();
+	int error = PMPI_Start(request);
+	record(PROFILE_START, bytes, time);
+	return error;
+}
+
+int MPI_Startall(int count, MPI_Request requests[]){
+	int i;
+	long long bytes = 0;
+	double time;
+	int error;
+	for(i=0;i<count;++i){
+		bytes += persistentBytes(requests[i]);
+	}
+	time = PMPI_Wtime();
+	error = PMPI_Startall(count, requests);
+	record(PROFILE_START, bytes, time);
+	return error;
+}
+
+int MPI_Wait(MPI_Request* request, MPI_Status* status){
+	double time = PMPI_Wtime();
+	int error = PMPI_Wait(request, status);
+	record(PROFILE_WAIT, 0, time);
+	return error;
+}
+
+int MPI_Waitall(int count, MPI_Request requests[], MPI_Status statuses[]){
+	double time = PMPI_Wtime();
+	int error = PMPI_Waitall(count, requests, statuses);
+	record(PROFILE_WAITALL, 0, time);
+	return error;
+}
+
+int MPI_Barrier(MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Barrier(comm);
+	record(PROFILE_BARRIER, 0, time);
+	return error;
+}
+
+int MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Bcast(buffer, count, datatype, root, comm);
+	record(PROFILE_BCAST, typeBytes(count, datatype), time);
+	return error;
+}
+
+int MPI_Reduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
+	record(PROFILE_REDUCE, typeBytes(count, datatype), time);
+	return error;
+}
+
+int MPI_Allreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+	record(PROFILE_ALLREDUCE, typeBytes(count, datatype), time);
+	return error;
+}
+
+int MPI_Iallreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+	MPI_Request* request){
+	double time = PMPI_Wtime();
+	int error = PMPI_Iallreduce(sendbuf, recvbuf, count, datatype, op, comm, request);
+	record(PROFILE_IALLREDUCE, typeBytes(count, datatype), time);
+	return error;
+}
+
+int MPI_Scatter(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount,
+	MPI_Datatype recvtype, int root, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Scatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+	record(PROFILE_SCATTER, typeBytes(recvcount, recvtype), time);
+	return error;
+}
+
+int MPI_Scatterv(const void* sendbuf, const int sendcounts[], const int displs[], MPI_Datatype sendtype,
+	void* recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Scatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm);
+	record(PROFILE_SCATTERV, typeBytes(recvcount, recvtype), time);
+	return error;
+}
+
+int MPI_Gather(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount,
+	MPI_Datatype recvtype, int root, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+	record(PROFILE_GATHER, typeBytes(sendcount, sendtype), time);
+	return error;
+}
+
+int MPI_Gatherv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, const int recvcounts[],
+	const int displs[], MPI_Datatype recvtype, int root, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+	record(PROFILE_GATHERV, typeBytes(sendcount, sendtype), time);
+	return error;
+}
+
+int MPI_Allgather(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount,
+	MPI_Datatype recvtype, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+	record(PROFILE_ALLGATHER, typeBytes(sendcount, sendtype), time);
+	return error;
+}
+
+int MPI_Allgatherv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, const int recvcounts[],
+	const int displs[], MPI_Datatype recvtype, MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Allgatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, comm);
+	record(PROFILE_ALLGATHERV, typeBytes(sendcount, sendtype), time);
+	return error;
+}
+
+int MPI_Iallgatherv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, const int recvcounts[],
+	const int displs[], MPI_Datatype recvtype, MPI_Comm comm, MPI_Request* request){
+	double time = PMPI_Wtime();
+	int error = PMPI_Iallgatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, comm, request);
+	record(PROFILE_IALLGATHERV, typeBytes(sendcount, sendtype), time);
+	return error;
+}
+
+int MPI_Neighbor_alltoallw(const void* sendbuf, const int sendcounts[], const MPI_Aint sdispls[],
+	const MPI_Datatype sendtypes[], void* recvbuf, const int recvcounts[], const MPI_Aint rdispls[],
+	const MPI_Datatype recvtypes[], MPI_Comm comm){
+	double time = PMPI_Wtime();
+	int error = PMPI_Neighbor_alltoallw(sendbuf, sendcounts, sdispls, sendtypes, recvbuf, recvcounts, rdispls,
+		recvtypes, comm);
+	record(PROFILE_NEIGHBOR_ALLTOALLW, neighborBytes(sendcounts, sendtypes, comm), time);
+	return error;
+}
+
+int MPI_Ineighbor_alltoallw(const void* sendbuf, const int sendcounts[], const MPI_Aint sdispls[],
+	const MPI_Datatype sendtypes[], void* recvbuf, const int recvcounts[], const MPI_Aint rdispls[],
+	const MPI_Datatype recvtypes[], MPI_Comm comm, MPI_Request* request){
+	double time = PMPI_Wtime();
+	int error = PMPI_Ineighbor_alltoallw(sendbuf, sendcounts, sdispls, sendtypes, recvbuf, recvcounts, rdispls,
+		recvtypes, comm, request);
+	record(PROFILE_INEIGHBOR_ALLTOALLW, neighborBytes(sendcounts, sendtypes, comm), time);
+	return error;
+}
+
+int MPI_File_read_at_all(MPI_File fh, MPI_Offset offset, void* buf, int count, MPI_Datatype datatype,
+	MPI_Status* status){
+	double time = PMPI_Wtime();
+	int error = PMPI_File_read_at_all(fh, offset, buf, count, datatype, status);
+	record(PROFILE_FILE_READ_AT_ALL, typeBytes(count, datatype), time);
+	return error;
+}
+
+int MPI_File_write_at_all(MPI_File fh, MPI_Offset offset, const void* buf, int count, MPI_Datatype datatype,
+	MPI_Status* status){
+	double time = PMPI_Wtime();
+	int error = PMPI_File_write_at_all(fh, offset, buf, count, datatype, status);
+	record(PROFILE_FILE_WRITE_AT_ALL, typeBytes(count, datatype), time);
+	return error;
+}
@@ -0,0 +1,29 @@
+#ifndef MPI_PROFILE_H
+#define MPI_PROFILE_H
+#include <mpi.h>
+
+/*
+ * Profiling of the MPI programs with the PMPI interface (mpi_profile.c):
+ * the library defines the MPI functions called by the programs, records the number of calls,
+ * the bytes and the time spent in each of them, and calls the PMPI version of the function.
+ * At MPI_Finalize, the records of all the processes are gathered on process 0,
+ * which prints a single report: one line per process, then one line per MPI function.
+ *
+ * the programs are not changed: the library is linked before the MPI library,
+ * mpicc -o pi pi.c mpi_profile.c -lm
+ * or preloaded at run time,
+ * mpirun -np 4 -x LD_PRELOAD=./libmpi_profile.so ./pi
+ *
+ * the solvers mark the end of each iteration with MPI_Pcontrol(MPI_PROFILE_ITERATION):
+ * the report then gives the compute time per iteration (the time outside MPI between the first
+ * and the last mark) next to the MPI time per iteration. The first iteration ends at the first mark,
+ * so it is not timed: n marks give n-1 timed iterations.
+ * Without the library, MPI_Pcontrol does nothing.
+ */
+
+/* levels of MPI_Pcontrol, 0 and 1 are the levels of the MPI standard */
+#define MPI_PROFILE_OFF 0		/* stop recording */
+#define MPI_PROFILE_ON 1		/* record again (the default) */
+#define MPI_PROFILE_ITERATION 3		/* end of an iteration of the solver */
+
+#endif
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <getopt.h>
+#include "matrix_io.h"
+
+/*
+ * Conversion of the matrix files (matrix_io.h): a text file (mvm.txt) to a binary file,
+ * or a binary file to a text file, the direction is given by the header of the input.
+ * the time to load the input and to write the output are reported, then the time to map the binary file.
+ * the pages of a mapping are only read from the file when they are touched, so a mapped file is also
+ * read once (the sum of its values) in the time of its load, to compare it with the text read
+ */
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, matrix_type* type, int* rows, int* cols, int* threads, char** inputName,
+	char** outputName);
+/* sum of the values, which touches all the pages of a mapped matrix */
+double sumValues(const matrix* m);
+double now(void);
+
+/*
+ * to compile:
+ * gcc -O2 -o matrix_convert matrix_convert.c matrix_io.c -pthread
+ * to run:
+ * ./matrix_convert -t int mvm.txt mvm.bin
+ * ./matrix_convert mvm.bin mvm2.txt
+ */
+int main(int argc, char* argv[]){
+
+	matrix_type type = MATRIX_INT32;
+	int rows = 0, cols = 0;
+	int threads = 4;
+	char *inputName, *outputName;
+	matrix m;
+	int binary, ok;
+	double loadTime, writeTime, mapTime;
+	double sum;
+
+	parseArgs(argc, argv, &type, &rows, &cols, &threads, &inputName, &outputName);
+	binary = matrix_is_binary(inputName);
+	loadTime = now();
+	ok = binary ? matrix_map(inputName, &m) : matrix_read_text(inputName, type, rows, cols, threads, &m);
+	if(ok && binary) sum = sumValues(&m);
+	loadTime = now()-loadTime;
+	if(!ok) return 1;
+	writeTime = now();
+	ok = binary ? matrix_write_text(outputName, &m) : matrix_write_binary(outputName, &m);
+	writeTime = now()-writeTime;
+	printf("%s: %d x %d %s values, %s read in %f (s), written in %f (s)\n", inputName, m.rows, m.cols,
+		matrix_type_name(m.type), binary ? "mapped and" : "text", loadTime, writeTime);
+	matrix_free(&m);
+	if(!ok) return 1;
+	if(!binary){
+		/*
+		 * the binary file is used in place
+		 */
+		mapTime = now();
+		ok = matrix_map(outputName, &m);
+		if(ok) sum = sumValues(&m);
+		mapTime = now()-mapTime;
+		if(ok){
+			printf("%s mapped and read in %f (s), sum of the values %g\n", outputName, mapTime, sum);
+			matrix_free(&m);
+		}
+	}
+	return ok ? 0 : 1;
+}
+
+double sumValues(const matrix* m){
+	size_t i, count = (size_t) m->rows*m->cols;
+	double sum = 0.0;
+	for(i=0;i<count;++i){
+		switch(m->type){
+			case MATRIX_INT32:
+				sum += ((const int32_t*) m->data)[i];
+				break;
+			case MATRIX_FLOAT32:
+				sum += ((const float*) m->data)[i];
+				break;
+			default:
+				sum += ((const double*) m->data)[i];
+		}
+	}
+	return sum;
+}
+
+double now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+void parseArgs(int argc, char** argv, matrix_type* type, int* rows, int* cols, int* threads, char** inputName,
+	char** outputName){
+	int c;
+	while((c=getopt(argc, argv, "t:r:c:j:")) != -1){
+		switch(c){
+			case 't':
+				if(!matrix_type_parse(optarg, type)){
+					printf("the type is int, float or double\n");
+					exit(1);
+				}
+				break;
+			case 'r':
+				*rows = atoi(optarg);
+				break;
+			case 'c':
+				*cols = atoi(optarg);
+				break;
+			case 'j':
+				*threads = atoi(optarg);
+				break;
+			default:
+				printf("usage: %s [-t type] [-r rows] [-c cols] [-j threads] input output\n", argv[0]);
+				exit(1);
+		}
+	}
+	if(argc-optind != 2 || *threads < 1){
+		printf("usage: %s [-t type] [-r rows] [-c cols] [-j threads] input output\n", argv[0]);
+		exit(1);
+	}
+	*inputName = argv[optind];
+	*outputName = argv[optind+1];
+}
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "matrix_io.h"
+
+/* part of a text file parsed by a thread */
+typedef struct{
+	const char* text;
+	size_t begin, end;	/* the values starting in begin..end-1 */
+	long count;		/* values of the part */
+	long firstValue;	/* index of the first value of the part */
+	long total;		/* values kept, the others are ignored */
+	matrix* m;
+	int ok;
+} text_part;
+
+static int blank(char c){
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+size_t matrix_type_size(matrix_type type){
+	switch(type){
+		case MATRIX_INT32: return sizeof(int32_t);
+		case MATRIX_FLOAT32: return sizeof(float);
+		default: return sizeof(double);
+	}
+}
+
+const char* matrix_type_name(matrix_type type){
+	switch(type){
+		case MATRIX_INT32: return "int";
+		case MATRIX_FLOAT32: return "float";
+		default: return "double";
+	}
+}
+
+int matrix_type_parse(const char* name, matrix_type* type){
+	if(strcmp(name, "int") == 0) *type = MATRIX_INT32;
+	else if(strcmp(name, "float") == 0) *type = MATRIX_FLOAT32;
+	else if(strcmp(name, "double") == 0) *type = MATRIX_FLOAT64;
+	else return 0;
+	return 1;
+}
+
+static void headerInit(matrix_io_header* header, const matrix* m){
+	memset(header, 0, sizeof(matrix_io_header));
+	strncpy(header->magic, MATRIX_IO_MAGIC, sizeof(header->magic));
+	header->version = MATRIX_IO_VERSION;
+	header->byteOrder = 1;
+	header->type = m->type;
+	header->rows = m->rows;
+	header->cols = m->cols;
+	header->offset = MATRIX_IO_HEADER_SIZE;
+}
+
+static int headerCheck(const matrix_io_header* header, const char* name){
+	if(strncmp(header->magic, MATRIX_IO_MAGIC, sizeof(header->magic)) != 0){
+		printf("%s is not a binary matrix file\n", name);
+		return 0;
+	}
+	if(header->byteOrder != 1){
+		printf("%s has another byte order\n", name);
+		return 0;
+	}
+	if(header->version != MATRIX_IO_VERSION || header->type < MATRIX_INT32 || header->type > MATRIX_FLOAT64
+		|| header->rows < 1 || header->cols < 1 || header->offset < MATRIX_IO_HEADER_SIZE){
+		printf("%s: unsupported version, type or size\n", name);
+		return 0;
+	}
+	return 1;
+}
+
+int matrix_is_binary(const char* name){
+	char magic[8];
+	int binary = 0;
+	FILE* input = fopen(name, "rb");
+	if(input == NULL) return 0;
+	if(fread(magic, sizeof(magic), 1, input) == 1){
+		binary = strncmp(magic, MATRIX_IO_MAGIC, sizeof(magic)) == 0;
+	}
+	fclose(input);
+	return binary;
+}
+
+int matrix_map(const char* name, matrix* m){
+	struct stat status;
+	const matrix_io_header* header;
+	int ok;
+	int file = open(name, O_RDONLY);
+	if(file < 0 || fstat(file, &status) != 0 || (size_t) status.st_size < sizeof(matrix_io_header)){
+		printf("Error reading %s\n", name);
+		if(file >= 0) close(file);
+		return 0;
+	}
+	m->mapSize = status.st_size;
+	m->map = mmap(NULL, m->mapSize, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if(m->map == MAP_FAILED){
+		printf("Error mapping %s\n", name);
+		m->map = NULL;
+		return 0;
+	}
+	header = (const matrix_io_header*) m->map;
+	ok = headerCheck(header, name);
+	if(ok && m->mapSize < header->offset+matrix_type_size(header->type)*(size_t)header->rows*header->cols){
+		printf("%s is too short for %d x %d values\n", name, header->rows, header->cols);
+		ok = 0;
+	}
+	if(!ok){
+		munmap(m->map, m->mapSize);
+		m->map = NULL;
+		return 0;
+	}
+	m->rows = header->rows;
+	m->cols = header->cols;
+	m->type = (matrix_type) header->type;
+	m->data = (char*) m->map+header->offset;
+	/*
+	 * the values are read once, in order
+	 */
+	madvise(m->map, m->mapSize, MADV_SEQUENTIAL);
+	return 1;
+}
+
+static void* countValues(void* argument){
+	text_part* part = (text_part*) argument;
+	size_t i;
+	part->count = 0;
+	for(i=part->begin;i<part->end;++i){
+		if(!blank(part->text[i]) && (i == 0 || blank(part->text[i-1]))) ++part->count;
+	}
+	return NULL;
+}
+
+static void* parseValues(void* argument){
+	text_part* part = (text_part*) argument;
+	const char* p = part->text+part->begin;
+	const char* end = part->text+part->end;
+	char* next;
+	long index = part->firstValue;
+	char* data = (char*) part->m->data;
+	part->ok = 1;
+	/*
+	 * begin is the start of a value or a blank
+	 */
+	while(p < end && index < part->total){
+		while(p < end && blank(*p)) ++p;
+		if(p == end) break;
+		switch(part->m->type){
+			case MATRIX_INT32:
+				((int32_t*) data)[index] = (int32_t) strtol(p, &next, 10);
+				break;
+			case MATRIX_FLOAT32:
+				((float*) data)[index] = strtof(p, &next);
+				break;
+			default:
+				((double*) data)[index] = strtod(p, &next);
+		}
+		if(next == p || (*next != '\0' && !blank(*next))){
+			part->ok = 0;
+			break;
+		}
+		p = next;
+		++index;
+	}
+	return NULL;
+}
+
+int matrix_read_text(const char* name, matrix_type type, int rows, int cols, int threads, matrix* m){
+	FILE* input;
+	char* text;
+	size_t size, i;
+	long total;
+	int t, ok = 1, findRows = rows <= 0;
+	text_part* parts;
+	pthread_t* handles;
+
+	input = fopen(name, "rb");
+	if(input == NULL){
+		printf("Error reading %s\n", name);
+		return 0;
+	}
+	fseek(input, 0, SEEK_END);
+	size = ftell(input);
+	fseek(input, 0, SEEK_SET);
+	text = (char*) malloc(size+1);
+	if(text == NULL || fread(text, 1, size, input) != size){
+		printf("Error reading %s\n", name);
+		fclose(input);
+		free(text);
+		return 0;
+	}
+	fclose(input);
+	text[size] = '\0';
+	if(threads < 1) threads = 1;
+	if((size_t) threads > size/4096+1) threads = size/4096+1;
+
+	/*
+	 * the values of the parts, counted by the threads
+	 */
+	parts = (text_part*) malloc(sizeof(text_part)*threads);
+	handles = (pthread_t*) malloc(sizeof(pthread_t)*threads);
+	for(t=0;t<threads;++t){
+		parts[t].text = text;
+		parts[t].begin = size*t/threads;
+		parts[t].end = size*(t+1)/threads;
+		parts[t].m = m;
+		pthread_create(&handles[t], NULL, countValues, &parts[t]);
+	}
+	for(t=0;t<threads;++t){
+		pthread_join(handles[t], NULL);
+	}
+	total = 0;
+	for(t=0;t<threads;++t){
+		parts[t].firstValue = total;
+		total += parts[t].count;
+	}
+	if(cols <= 0){
+		/*
+		 * the values of the first line which has values
+		 */
+		cols = 0;
+		for(i=0;i<size;++i){
+			if(!blank(text[i]) && (i == 0 || blank(text[i-1]))) ++cols;
+			if(text[i] == '\n' && cols > 0) break;
+		}
+	}
+	if(cols > 0 && findRows) rows = total/cols;
+	if(cols <= 0 || rows <= 0 || total < (long) rows*cols || (findRows && total%cols != 0)){
+		printf("%s: %ld values, not a matrix of %d x %d values\n", name, total, rows, cols);
+		ok = 0;
+	}
+
+	/*
+	 * the values, parsed by the threads at their position
+	 */
+	if(ok){
+		m->rows = rows;
+		m->cols = cols;
+		m->type = type;
+		m->map = NULL;
+		m->mapSize = 0;
+		m->data = malloc(matrix_type_size(type)*(size_t)rows*cols);
+		if(m->data == NULL){
+			printf("not enough memory for %d x %d values\n", rows, cols);
+			ok = 0;
+		}
+	}
+	if(ok){
+		for(t=0;t<threads;++t){
+			/*
+			 * a part starting inside a value starts after it, the previous part parses it
+			 */
+			while(parts[t].begin < size && parts[t].begin > 0 && !blank(text[parts[t].begin-1])
+				&& !blank(text[parts[t].begin])) ++parts[t].begin;
+			parts[t].total = (long) rows*cols;
+			pthread_create(&handles[t], NULL, parseValues, &parts[t]);
+		}
+		for(t=0;t<threads;++t){
+			pthread_join(handles[t], NULL);
+			if(!parts[t].ok) ok = 0;
+		}
+		if(!ok){
+			printf("%s: a value is not a number\n", name);
+			free(m->data);
+			m->data = NULL;
+		}
+	}
+	free(parts);
+	free(handles);
+	free(text);
+	return ok;
+}
+
+int matrix_load(const char* name, matrix_type type, int threads, matrix* m){
+	if(matrix_is_binary(name)){
+		if(!matrix_map(name, m)) return 0;
+		if(m->type != type){
+			printf("%s holds %s values, not %s\n", name, matrix_type_name(m->type), matrix_type_name(type));
+			matrix_free(m);
+			return 0;
+		}
+		return 1;
+	}
+	return matrix_read_text(name, type, 0, 0, threads, m);
+}
+
+int matrix_write_binary(const char* name, const matrix* m){
+	matrix_io_header header;
+	size_t values = (size_t) m->rows*m->cols;
+	int ok;
+	FILE* output = fopen(name, "wb");
+	if(output == NULL){
+		printf("Error writing %s\n", name);
+		return 0;
+	}
+	headerInit(&header, m);
+	ok = fwrite(&header, sizeof(header), 1, output) == 1
+		&& fwrite(m->data, matrix_type_size(m->type), values, output) == values;
+	if(fclose(output) != 0) ok = 0;
+	if(!ok) printf("Error writing %s\n", name);
+	return ok;
+}
+
+int matrix_write_text(const char* name, const matrix* m){
+	int i, j, ok;
+	size_t k;
+	FILE* output = fopen(name, "w");
+	if(output == NULL){
+		printf("Error writing %s\n", name);
+		return 0;
+	}
+	for(i=0;i<m->rows;++i){
+		for(j=0;j<m->cols;++j){
+			k = (size_t)i*m->cols+j;
+			switch(m->type){
+				case MATRIX_INT32:
+					fprintf(output, "%d", ((const int32_t*) m->data)[k]);
+					break;
+				case MATRIX_FLOAT32:
+					fprintf(output, "%.9g", ((const float*) m->data)[k]);
+					break;
+				default:
+					fprintf(output, "%.17g", ((const double*) m->data)[k]);
+			}
+			fputc(j == m->cols-1 ? '\n' : ' ', output);
+		}
+	}
+	ok = fclose(output) == 0;
+	if(!ok) printf("Error writing %s\n", name);
+	return ok;
+}
+
+void matrix_free(matrix* m){
+	if(m->map != NULL){
+		munmap(m->map, m->mapSize);
+	}else{
+		free(m->data);
+	}
+	m->map = NULL;
+	m->data = NULL;
+}
@@ -0,0 +1,71 @@
+#ifndef MATRIX_IO_H
+#define MATRIX_IO_H
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Dense matrix files:
+ * + binary: a header of MATRIX_IO_HEADER_SIZE bytes with the size and the type, then the rows x cols values
+ *   row after row, starting at an offset aligned to MATRIX_IO_HEADER_SIZE. The file is mapped in memory
+ *   (mmap): the values are used in place, only the pages touched are read from the disk.
+ *   the values are written in the byte order of the machine, the header records it so a file from
+ *   another byte order is refused (the same layout as ../lecture5/jacobi_io.h)
+ * + text: the values separated by spaces or new lines (mvm.txt), read at once and parsed by threads:
+ *   each thread counts the values of its part of the file, then parses them at their position.
+ *   the files are converted with matrix_convert.c
+ */
+
+#define MATRIX_IO_MAGIC "MATRIXB"
+#define MATRIX_IO_VERSION 1
+#define MATRIX_IO_HEADER_SIZE 64
+
+/* type of the values */
+typedef enum{
+	MATRIX_INT32 = 1,
+	MATRIX_FLOAT32,
+	MATRIX_FLOAT64
+} matrix_type;
+
+typedef struct{
+	char magic[8];		/* MATRIX_IO_MAGIC */
+	int32_t version;
+	int32_t byteOrder;	/* 1 in the byte order of the writer */
+	int32_t type;		/* matrix_type */
+	int32_t rows, cols;
+	int32_t reserved;
+	int64_t offset;		/* offset of the first value */
+	char padding[MATRIX_IO_HEADER_SIZE-40];
+} matrix_io_header;
+
+typedef struct{
+	int rows, cols;
+	matrix_type type;
+	void* data;		/* rows x cols values, row after row */
+	void* map;		/* mapping of a binary file (read only), NULL if data is allocated */
+	size_t mapSize;
+} matrix;
+
+size_t matrix_type_size(matrix_type type);
+const char* matrix_type_name(matrix_type type);
+/* int, float or double, returns 0 for another name */
+int matrix_type_parse(const char* name, matrix_type* type);
+/* 1 if the file starts with the binary header */
+int matrix_is_binary(const char* name);
+/*
+ * maps a binary file, returns 0 with a message if it cannot be read;
+ * the values of m are read only
+ */
+int matrix_map(const char* name, matrix* m);
+/*
+ * reads a text file with threads, rows and cols of 0 are found from the file
+ * (cols is the number of values of the first line), returns 0 with a message on error
+ */
+int matrix_read_text(const char* name, matrix_type type, int rows, int cols, int threads, matrix* m);
+/* binary or text file of values of the given type */
+int matrix_load(const char* name, matrix_type type, int threads, matrix* m);
+/* returns 0 if the file cannot be written */
+int matrix_write_binary(const char* name, const matrix* m);
+int matrix_write_text(const char* name, const matrix* m);
+void matrix_free(matrix* m);
+
+#endif
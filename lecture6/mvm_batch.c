@@ -0,0 +1,191 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include "mvm_kernel.h"
+
+/*
+ * Dense matrix-vector products of k vectors by a n x n matrix of doubles with pthreads,
+ * the rows split in blocks among the threads (the first n%threads threads own one more row):
+ * + naive: k products of the loop of pthreadsMVM.c
+ * + blocked: k products of the register and cache blocked kernel (mvm_kernel.h)
+ * + batch: the k vectors multiplied at once, each value of A read once for the k vectors
+ * the time per vector and the GFLOP/s (2 n^2 per vector) are reported.
+ */
+
+/* the products */
+typedef enum{
+	KERNEL_NAIVE = 0,
+	KERNEL_BLOCKED,
+	KERNEL_BATCH,
+	KERNELS
+} batch_kernel;
+
+static const char* kernelNames[KERNELS] = {"naive", "blocked", "batch"};
+
+/* work of a thread */
+typedef struct{
+	batch_kernel kernel;
+	int first, count;
+} thread_work;
+
+/* shared by the threads */
+int n, k, iterations;
+double *A;
+double *vectors, *results;	/* k vectors of n values, one after the other */
+double *X, *Y;			/* n x k, the k values of a row together */
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int* n, int* k, int* threads, int* iterations);
+/* the iterations of a kernel on the rows of a thread */
+void* MVM(void* argument);
+double now(void);
+
+/*
+ * to compile:
+ * gcc -O2 -march=native -o mvm_batch mvm_batch.c mvm_kernel.c -pthread -lm
+ * to run, 16 vectors by a 4096 x 4096 matrix with 4 threads:
+ * ./mvm_batch -n 4096 -k 16 -t 4
+ */
+int main(int argc, char* argv[]){
+
+	int threads = 4;
+	int i, j, v, t, kernel;
+	pthread_t* handles;
+	thread_work* work;
+	double time, error, e;
+
+	n = 2048;
+	k = 8;
+	iterations = 10;
+	parseArgs(argc, argv, &n, &k, &threads, &iterations);
+	A = mvm_aligned_alloc((size_t) n*n);
+	vectors = mvm_aligned_alloc((size_t) n*k);
+	results = mvm_aligned_alloc((size_t) n*k);
+	X = mvm_aligned_alloc((size_t) n*k);
+	Y = mvm_aligned_alloc((size_t) n*k);
+	if(A == NULL || vectors == NULL || results == NULL || X == NULL || Y == NULL){
+		printf("not enough memory for a %d x %d matrix\n", n, n);
+		return 1;
+	}
+	for(i=0;i<n;++i){
+		for(j=0;j<n;++j){
+			A[(size_t)i*n+j] = 1.0/(1+(i+j)%7);
+		}
+	}
+	for(v=0;v<k;++v){
+		for(j=0;j<n;++j){
+			vectors[(size_t)v*n+j] = X[(size_t)j*k+v] = 1.0/(1+(j+v)%5);
+		}
+	}
+
+	handles = (pthread_t*) malloc(sizeof(pthread_t)*threads);
+	work = (thread_work*) malloc(sizeof(thread_work)*threads);
+	for(t=0;t<threads;++t){
+		work[t].count = n/threads+(t < n%threads);
+		work[t].first = t == 0 ? 0 : work[t-1].first+work[t-1].count;
+	}
+	printf("matrix %d x %d, %d vectors, %d threads, %s kernels\n", n, n, k, threads, mvm_kernel_isa());
+	printf("kernel\t\ttime/vector (us)\tGFLOP/s\t\terror\n");
+	for(kernel=0;kernel<KERNELS;++kernel){
+		time = now();
+		for(t=0;t<threads;++t){
+			work[t].kernel = kernel;
+			pthread_create(&handles[t], NULL, MVM, (void*) &work[t]);
+		}
+		for(t=0;t<threads;++t){
+			pthread_join(handles[t], NULL);
+		}
+		time = now()-time;
+		/*
+		 * the naive products are the reference
+		 */
+		error = 0.0;
+		if(kernel == KERNEL_BATCH){
+			for(v=0;v<k;++v){
+				for(i=0;i<n;++i){
+					e = fabs(Y[(size_t)i*k+v]-results[(size_t)v*n+i])/fabs(results[(size_t)v*n+i]);
+					if(e > error) error = e;
+				}
+			}
+		}else if(kernel == KERNEL_BLOCKED){
+			for(v=0;v<k;++v){
+				for(i=0;i<n;++i){
+					e = fabs(Y[(size_t)v*n+i]-results[(size_t)v*n+i])/fabs(results[(size_t)v*n+i]);
+					if(e > error) error = e;
+				}
+			}
+		}
+		printf("%-12s\t%f\t\t%f\t%g\n", kernelNames[kernel], 1e6*time/iterations/k,
+			2.0*n*n*k*iterations/time/1e9, error);
+	}
+
+	free(A);
+	free(vectors);
+	free(results);
+	free(X);
+	free(Y);
+	free(handles);
+	free(work);
+	return 0;
+}
+
+void* MVM(void* argument){
+	thread_work* work = (thread_work*) argument;
+	int it, v;
+	for(it=0;it<iterations;++it){
+		switch(work->kernel){
+			case KERNEL_NAIVE:
+				for(v=0;v<k;++v){
+					mvm_naive(A, vectors+(size_t)v*n, results+(size_t)v*n, n, work->first, work->count);
+				}
+				break;
+			case KERNEL_BLOCKED:
+				/*
+				 * Y holds the k results one after the other
+				 */
+				for(v=0;v<k;++v){
+					mvm_blocked(A, vectors+(size_t)v*n, Y+(size_t)v*n, n, work->first, work->count);
+				}
+				break;
+			default:
+				mvm_batch(A, X, Y, n, k, work->first, work->count);
+		}
+	}
+	return NULL;
+}
+
+double now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+void parseArgs(int argc, char** argv, int* n, int* k, int* threads, int* iterations){
+	int c;
+	while((c=getopt(argc, argv, "n:k:t:i:")) != -1){
+		switch(c){
+			case 'n':
+				*n = atoi(optarg);
+				break;
+			case 'k':
+				*k = atoi(optarg);
+				break;
+			case 't':
+				*threads = atoi(optarg);
+				break;
+			case 'i':
+				*iterations = atoi(optarg);
+				break;
+			default:
+				printf("usage: %s [-n size] [-k vectors] [-t threads] [-i iterations]\n", argv[0]);
+				exit(1);
+		}
+	}
+	if(*n < 1 || *k < 1 || *threads < 1 || *iterations < 1){
+		printf("the arguments must be positive\n");
+		exit(1);
+	}
+}
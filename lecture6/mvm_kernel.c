@@ -0,0 +1,220 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mvm_kernel.h"
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define MVM_AVX2
+#endif
+
+double* mvm_aligned_alloc(size_t n){
+	void* p = NULL;
+	if(posix_memalign(&p, 64, sizeof(double)*(n > 0 ? n : 1)) != 0) return NULL;
+	return (double*) p;
+}
+
+void mvm_naive(const double* A, const double* x, double* y, int cols, int first, int count){
+	int i, j;
+	for(i=first;i<first+count;++i){
+		y[i] = 0.0;
+		for(j=0;j<cols;++j){
+			y[i] += A[(size_t)i*cols+j]*x[j];
+		}
+	}
+}
+
+#ifdef MVM_AVX2
+/* sum of the 4 values of a register */
+static inline double sum4(__m256d v){
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+#endif
+
+/* y[0..rows-1] += the columns begin..end-1 of rows rows (at most MVM_ROWS) starting at a */
+static void blockRows(const double* a, const double* x, double* y, int cols, int rows, int begin, int end){
+	int r, j = begin;
+	double s[MVM_ROWS];
+#ifdef MVM_AVX2
+	if(rows == MVM_ROWS){
+		const double *a0 = a, *a1 = a+cols, *a2 = a+2*(size_t)cols, *a3 = a+3*(size_t)cols;
+		__m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd(), c2 = _mm256_setzero_pd(), c3 = _mm256_setzero_pd();
+		for(;j+4<=end;j+=4){
+			__m256d xv = _mm256_loadu_pd(x+j);
+			c0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0+j), xv, c0);
+			c1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1+j), xv, c1);
+			c2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2+j), xv, c2);
+			c3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3+j), xv, c3);
+		}
+		s[0] = sum4(c0);
+		s[1] = sum4(c1);
+		s[2] = sum4(c2);
+		s[3] = sum4(c3);
+	}else{
+		for(r=0;r<rows;++r){
+			const double* ar = a+(size_t)r*cols;
+			__m256d c = _mm256_setzero_pd();
+			for(j=begin;j+4<=end;j+=4){
+				c = _mm256_fmadd_pd(_mm256_loadu_pd(ar+j), _mm256_loadu_pd(x+j), c);
+			}
+			s[r] = sum4(c);
+		}
+	}
+#else
+	for(r=0;r<rows;++r) s[r] = 0.0;
+	for(;j<end;++j){
+		for(r=0;r<rows;++r){
+			s[r] += a[(size_t)r*cols+j]*x[j];
+		}
+	}
+#endif
+	/*
+	 * the columns left over by the registers
+	 */
+	for(r=0;r<rows;++r){
+		int jr;
+		for(jr=j;jr<end;++jr){
+			s[r] += a[(size_t)r*cols+jr]*x[jr];
+		}
+		y[r] += s[r];
+	}
+}
+
+void mvm_blocked(const double* A, const double* x, double* y, int cols, int first, int count){
+	int i, begin, end, rows, last = first+count;
+	for(i=first;i<last;++i){
+		y[i] = 0.0;
+	}
+	for(begin=0;begin<cols;begin+=MVM_BLOCK){
+		end = begin+MVM_BLOCK < cols ? begin+MVM_BLOCK : cols;
+		for(i=first;i<last;i+=MVM_ROWS){
+			rows = last-i < MVM_ROWS ? last-i : MVM_ROWS;
+			blockRows(A+(size_t)i*cols, x, y+i, cols, rows, begin, end);
+		}
+	}
+}
+
+/*
+ * Y[0..rows-1][v..v+width-1] += the columns begin..end-1 of rows rows starting at a,
+ * times the rows begin..end-1 of X (any rows and width)
+ */
+static void batchBlock(const double* a, const double* X, double* Y, int cols, int k, int rows, int v, int width,
+	int begin, int end){
+	int r, w, j;
+	double ar;
+	for(r=0;r<rows;++r){
+		double* yr = Y+(size_t)r*k+v;
+		for(j=begin;j<end;++j){
+			const double* xj = X+(size_t)j*k+v;
+			ar = a[(size_t)r*cols+j];
+			for(w=0;w<width;++w){
+				yr[w] += ar*xj[w];
+			}
+		}
+	}
+}
+
+#ifdef MVM_AVX2
+/*
+ * the same for MVM_ROWS rows and 8 vectors: 8 sums in the registers, each value of A is
+ * broadcast and multiplied by 8 values of X
+ */
+static void batchBlock4x8(const double* a, const double* X, double* Y, int cols, int k, int v, int begin, int end){
+	const double *a0 = a, *a1 = a+cols, *a2 = a+2*(size_t)cols, *a3 = a+3*(size_t)cols;
+	__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+	__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd(), c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+	__m256d x0, x1, ar;
+	int j;
+	for(j=begin;j<end;++j){
+		const double* xj = X+(size_t)j*k+v;
+		x0 = _mm256_loadu_pd(xj);
+		x1 = _mm256_loadu_pd(xj+4);
+		ar = _mm256_broadcast_sd(a0+j);
+		c00 = _mm256_fmadd_pd(ar, x0, c00);
+		c01 = _mm256_fmadd_pd(ar, x1, c01);
+		ar = _mm256_broadcast_sd(a1+j);
+		c10 = _mm256_fmadd_pd(ar, x0, c10);
+		c11 = _mm256_fmadd_pd(ar, x1, c11);
+		ar = _mm256_broadcast_sd(a2+j);
+		c20 = _mm256_fmadd_pd(ar, x0, c20);
+		c21 = _mm256_fmadd_pd(ar, x1, c21);
+		ar = _mm256_broadcast_sd(a3+j);
+		c30 = _mm256_fmadd_pd(ar, x0, c30);
+		c31 = _mm256_fmadd_pd(ar, x1, c31);
+	}
+	Y += v;
+	_mm256_storeu_pd(Y, _mm256_add_pd(_mm256_loadu_pd(Y), c00));
+	_mm256_storeu_pd(Y+4, _mm256_add_pd(_mm256_loadu_pd(Y+4), c01));
+	Y += k;
+	_mm256_storeu_pd(Y, _mm256_add_pd(_mm256_loadu_pd(Y), c10));
+	_mm256_storeu_pd(Y+4, _mm256_add_pd(_mm256_loadu_pd(Y+4), c11));
+	Y += k;
+	_mm256_storeu_pd(Y, _mm256_add_pd(_mm256_loadu_pd(Y), c20));
+	_mm256_storeu_pd(Y+4, _mm256_add_pd(_mm256_loadu_pd(Y+4), c21));
+	Y += k;
+	_mm256_storeu_pd(Y, _mm256_add_pd(_mm256_loadu_pd(Y), c30));
+	_mm256_storeu_pd(Y+4, _mm256_add_pd(_mm256_loadu_pd(Y+4), c31));
+}
+
+/*
+ * the same for MVM_ROWS rows and width vectors, at most 4: the values of X and Y
+ * after width are masked out
+ */
+static void batchBlock4x4(const double* a, const double* X, double* Y, int cols, int k, int v, int width,
+	int begin, int end){
+	const double *a0 = a, *a1 = a+cols, *a2 = a+2*(size_t)cols, *a3 = a+3*(size_t)cols;
+	const __m256i mask = _mm256_setr_epi64x(-1, width > 1 ? -1 : 0, width > 2 ? -1 : 0, width > 3 ? -1 : 0);
+	__m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd(), c2 = _mm256_setzero_pd(), c3 = _mm256_setzero_pd();
+	__m256d x0;
+	int j;
+	for(j=begin;j<end;++j){
+		x0 = _mm256_maskload_pd(X+(size_t)j*k+v, mask);
+		c0 = _mm256_fmadd_pd(_mm256_broadcast_sd(a0+j), x0, c0);
+		c1 = _mm256_fmadd_pd(_mm256_broadcast_sd(a1+j), x0, c1);
+		c2 = _mm256_fmadd_pd(_mm256_broadcast_sd(a2+j), x0, c2);
+		c3 = _mm256_fmadd_pd(_mm256_broadcast_sd(a3+j), x0, c3);
+	}
+	Y += v;
+	_mm256_maskstore_pd(Y, mask, _mm256_add_pd(_mm256_maskload_pd(Y, mask), c0));
+	Y += k;
+	_mm256_maskstore_pd(Y, mask, _mm256_add_pd(_mm256_maskload_pd(Y, mask), c1));
+	Y += k;
+	_mm256_maskstore_pd(Y, mask, _mm256_add_pd(_mm256_maskload_pd(Y, mask), c2));
+	Y += k;
+	_mm256_maskstore_pd(Y, mask, _mm256_add_pd(_mm256_maskload_pd(Y, mask), c3));
+}
+#endif
+
+void mvm_batch(const double* A, const double* X, double* Y, int cols, int k, int first, int count){
+	int i, v, begin, end, rows, last = first+count;
+	memset(Y+(size_t)first*k, 0, sizeof(double)*(size_t)count*k);
+	/*
+	 * the block of X (MVM_BLOCK x k values) stays in the cache for all the rows
+	 */
+	for(begin=0;begin<cols;begin+=MVM_BLOCK){
+		end = begin+MVM_BLOCK < cols ? begin+MVM_BLOCK : cols;
+		for(i=first;i<last;i+=MVM_ROWS){
+			rows = last-i < MVM_ROWS ? last-i : MVM_ROWS;
+			v = 0;
+#ifdef MVM_AVX2
+			if(rows == MVM_ROWS){
+				for(;v+8<=k;v+=8){
+					batchBlock4x8(A+(size_t)i*cols, X, Y+(size_t)i*k, cols, k, v, begin, end);
+				}
+				for(;v<k;v+=4){
+					batchBlock4x4(A+(size_t)i*cols, X, Y+(size_t)i*k, cols, k, v, k-v < 4 ? k-v : 4, begin, end);
+				}
+			}
+#endif
+			if(v < k) batchBlock(A+(size_t)i*cols, X, Y+(size_t)i*k, cols, k, rows, v, k-v, begin, end);
+		}
+	}
+}
+
+const char* mvm_kernel_isa(void){
+#ifdef MVM_AVX2
+	return "AVX2/FMA";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,27 @@
+#ifndef MVM_KERNEL_H
+#define MVM_KERNEL_H
+#include <stddef.h>
+
+/*
+ * Dense matrix-vector products of a matrix of doubles with cols columns stored by rows,
+ * for the rows first..first+count-1 only, so the threads can share a product:
+ * + mvm_naive: y[i] += A[i][j]*x[j], as pthreadsMVM.c
+ * + mvm_blocked: MVM_ROWS rows at a time, so each value of x loaded is used MVM_ROWS times and the
+ *   sums are independent (AVX2/FMA registers when the compiler targets them, -march=native),
+ *   the columns in blocks of MVM_BLOCK so the block of x stays in the L1 cache
+ * + mvm_batch: Y = A X for k vectors at once, X stored as cols x k and Y as rows x k
+ *   (the k values of a row together): each value of A loaded is used k times, so the product
+ *   is bound by the computation and no longer by the bandwidth of the memory
+ */
+#define MVM_ROWS 4
+#define MVM_BLOCK 1024
+
+/* n doubles aligned on 64 bytes, freed with free */
+double* mvm_aligned_alloc(size_t n);
+void mvm_naive(const double* A, const double* x, double* y, int cols, int first, int count);
+void mvm_blocked(const double* A, const double* x, double* y, int cols, int first, int count);
+void mvm_batch(const double* A, const double* X, double* Y, int cols, int k, int first, int count);
+/* instructions of mvm_blocked and mvm_batch */
+const char* mvm_kernel_isa(void);
+
+#endif
@@ -0,0 +1,316 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <stdatomic.h>
+#include "reduction.h"
+
+#define MAX_DEPTH 50
+
+/*
+ * Adaptive Simpson quadrature with pthreads, against the uniform trapezoidal rule of pthreadsTrapez.c:
+ * an interval is cut in 2 halves, and the Simpson estimates of the halves are compared with the estimate
+ * of the whole interval: when they differ by at most 15 times the tolerance of the interval, the interval
+ * is done, else each half gets half of the tolerance and is refined again. The evaluations go where the
+ * function changes fast, instead of on a uniform grid.
+ * Each thread refines its intervals depth first on its own stack; while some threads are idle, a thread
+ * gives the oldest (largest) interval of its stack to the shared queue, where the idle threads take them
+ * (a mutex and a condition variable). The work ends when the queue is empty and all the threads are idle.
+ * For each integrand, the number of evaluations and the time to reach the tolerance are reported for
+ * + trapezoid: n doubled until the error of the uniform rule is below the tolerance (the last n is reported)
+ * + adaptive: the adaptive Simpson rule
+ */
+
+/* an integrand, with its interval and its integral */
+typedef struct{
+	const char* name;
+	double (*f)(double x);
+	double a, b;
+	double exact;
+} integrand;
+
+/* an interval to refine, with the values of f at its ends and middle and its Simpson estimate */
+typedef struct{
+	double a, b;
+	double fa, fm, fb;
+	double whole;
+	double tolerance;
+	int depth;
+} interval;
+
+/* the intervals of a thread, or of the shared queue */
+typedef struct{
+	interval* items;
+	int size, capacity;
+} interval_stack;
+
+double square(double x);
+double peak(double x);
+double root(double x);
+double gauss(double x);
+
+static integrand integrands[] = {
+	{"square", square, 0.0, 10.0, 1000.0/3.0},
+	{"peak", peak, 0.0, 1.0, 0.0},		/* set in main */
+	{"sqrt", root, 0.0, 1.0, 2.0/3.0},
+	{"gauss", gauss, 0.0, 3.0, 0.0}		/* set in main */
+};
+#define INTEGRANDS ((int) (sizeof(integrands)/sizeof(integrands[0])))
+
+/* shared by the threads */
+const integrand* current;
+int thread_count;
+double trapezoidH;
+long trapezoidN;
+interval_stack queue;
+pthread_mutex_t mutex;
+pthread_cond_t cond;
+atomic_int idle;
+reduction_slot *sums, *evaluations;
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, char** name, int* threads, double* tolerance);
+void push(interval_stack* s, const interval* item);
+/* the uniform trapezoidal rule on the block of the thread */
+void* trapezoidWork(void* rank);
+/* the adaptive rule on the intervals of the thread and of the queue */
+void* adaptiveWork(void* rank);
+/* runs a work on the threads, returns the sum of the slots */
+double run(void* (*work)(void*));
+double now(void);
+
+/*
+ * to compile:
+ * gcc -O2 -o pthreadsAdaptive pthreadsAdaptive.c reduction.c -pthread -lm
+ * to run, all the integrands with 4 threads and a tolerance of 1e-10:
+ * ./pthreadsAdaptive -t 4 -e 1e-10
+ */
+int main(int argc, char* argv[]){
+
+	char* name = NULL;
+	double tolerance = 1e-8;
+	double time, result, count;
+	int i;
+	interval start;
+
+	thread_count = 4;
+	parseArgs(argc, argv, &name, &thread_count, &tolerance);
+	integrands[1].exact = 100.0*(atan(70.0)+atan(30.0));
+	integrands[3].exact = 0.5*sqrt(M_PI)*erf(3.0);
+	sums = reduction_slots(thread_count);
+	evaluations = reduction_slots(thread_count);
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&cond, NULL);
+	queue.items = NULL;
+	queue.size = queue.capacity = 0;
+
+	printf("%d threads, tolerance %g\n", thread_count, tolerance);
+	printf("integrand\tmethod\t\tevaluations\ttime (s)\terror\n");
+	for(i=0;i<INTEGRANDS;++i){
+		current = &integrands[i];
+		if(name != NULL && strcmp(name, current->name) != 0) continue;
+		/*
+		 * uniform rule, n doubled until the tolerance is reached
+		 */
+		for(trapezoidN=16;;trapezoidN*=2){
+			trapezoidH = (current->b-current->a)/trapezoidN;
+			time = now();
+			result = run(trapezoidWork);
+			time = now()-time;
+			if(fabs(result-current->exact) <= tolerance || trapezoidN >= (1L << 28)) break;
+		}
+		printf("%-9s\ttrapezoid\t%ld\t\t%f\t%g\n", current->name, trapezoidN+1, time, fabs(result-current->exact));
+		/*
+		 * adaptive rule, from the whole interval
+		 */
+		time = now();
+		start.a = current->a;
+		start.b = current->b;
+		start.fa = current->f(start.a);
+		start.fm = current->f(0.5*(start.a+start.b));
+		start.fb = current->f(start.b);
+		start.whole = (start.b-start.a)/6.0*(start.fa+4.0*start.fm+start.fb);
+		start.tolerance = tolerance;
+		start.depth = 0;
+		queue.size = 0;
+		push(&queue, &start);
+		atomic_store(&idle, 0);
+		result = run(adaptiveWork);
+		time = now()-time;
+		count = reduction_slots_sum(evaluations, thread_count)+3;
+		printf("%-9s\tadaptive\t%.0f\t\t%f\t%g\n", current->name, count, time, fabs(result-current->exact));
+	}
+
+	pthread_mutex_destroy(&mutex);
+	pthread_cond_destroy(&cond);
+	free(queue.items);
+	free(sums);
+	free(evaluations);
+	return 0;
+}
+
+double run(void* (*work)(void*)){
+	int i;
+	long* ranks = (long*) malloc(sizeof(long)*thread_count);
+	pthread_t* handles = (pthread_t*) malloc(sizeof(pthread_t)*thread_count);
+	for(i=0;i<thread_count;++i){
+		ranks[i] = i;
+		sums[i].value = evaluations[i].value = 0.0;
+		pthread_create(&handles[i], NULL, work, &ranks[i]);
+	}
+	for(i=0;i<thread_count;++i){
+		pthread_join(handles[i], NULL);
+	}
+	free(ranks);
+	free(handles);
+	return reduction_slots_sum(sums, thread_count);
+}
+
+void* trapezoidWork(void* rank){
+	long my_rank = *((long*) rank);
+	long first = trapezoidN*my_rank/thread_count;
+	long last = trapezoidN*(my_rank+1)/thread_count;
+	long i;
+	double integral = 0.5*(current->f(current->a+first*trapezoidH)+current->f(current->a+last*trapezoidH));
+	for(i=first+1;i<last;++i){
+		integral += current->f(current->a+i*trapezoidH);
+	}
+	sums[my_rank].value = integral*trapezoidH;
+	return NULL;
+}
+
+void push(interval_stack* s, const interval* item){
+	if(s->size == s->capacity){
+		s->capacity = s->capacity > 0 ? 2*s->capacity : 64;
+		s->items = (interval*) realloc(s->items, sizeof(interval)*s->capacity);
+	}
+	s->items[s->size++] = *item;
+}
+
+void* adaptiveWork(void* rank){
+	long my_rank = *((long*) rank);
+	interval_stack local = {NULL, 0, 0};
+	interval task, left, right;
+	double sum = 0.0, c, fl, fr, estimate;
+	long count = 0;
+	for(;;){
+		if(local.size == 0){
+			/*
+			 * an interval of the queue, or the end when all the threads wait
+			 */
+			pthread_mutex_lock(&mutex);
+			atomic_fetch_add(&idle, 1);
+			while(queue.size == 0 && atomic_load(&idle) < thread_count){
+				pthread_cond_wait(&cond, &mutex);
+			}
+			if(queue.size == 0){
+				pthread_cond_broadcast(&cond);
+				pthread_mutex_unlock(&mutex);
+				break;
+			}
+			atomic_fetch_sub(&idle, 1);
+			push(&local, &queue.items[--queue.size]);
+			pthread_mutex_unlock(&mutex);
+		}
+		task = local.items[--local.size];
+		c = 0.5*(task.a+task.b);
+		fl = current->f(0.5*(task.a+c));
+		fr = current->f(0.5*(c+task.b));
+		count += 2;
+		left.a = task.a;
+		left.b = c;
+		left.fa = task.fa;
+		left.fm = fl;
+		left.fb = task.fm;
+		left.whole = (c-task.a)/6.0*(task.fa+4.0*fl+task.fm);
+		right.a = c;
+		right.b = task.b;
+		right.fa = task.fm;
+		right.fm = fr;
+		right.fb = task.fb;
+		right.whole = (task.b-c)/6.0*(task.fm+4.0*fr+task.fb);
+		estimate = left.whole+right.whole;
+		if(fabs(estimate-task.whole) <= 15.0*task.tolerance || task.depth >= MAX_DEPTH){
+			/*
+			 * Richardson extrapolation of the 2 estimates
+			 */
+			sum += estimate+(estimate-task.whole)/15.0;
+		}else{
+			left.tolerance = right.tolerance = 0.5*task.tolerance;
+			left.depth = right.depth = task.depth+1;
+			push(&local, &right);
+			push(&local, &left);
+			/*
+			 * the oldest interval of the stack is the largest one
+			 */
+			if(atomic_load_explicit(&idle, memory_order_relaxed) > 0 && local.size > 1){
+				pthread_mutex_lock(&mutex);
+				push(&queue, &local.items[0]);
+				memmove(local.items, local.items+1, sizeof(interval)*(local.size-1));
+				--local.size;
+				pthread_cond_signal(&cond);
+				pthread_mutex_unlock(&mutex);
+			}
+		}
+	}
+	sums[my_rank].value = sum;
+	evaluations[my_rank].value = count;
+	free(local.items);
+	return NULL;
+}
+
+/* f(x) = x², as pthreadsTrapez.c */
+double square(double x){
+	return x*x;
+}
+
+/* a sharp peak at 0.3 */
+double peak(double x){
+	return 1.0/(1e-4+(x-0.3)*(x-0.3));
+}
+
+/* an infinite derivative at 0 */
+double root(double x){
+	return sqrt(x);
+}
+
+double gauss(double x){
+	return exp(-x*x);
+}
+
+double now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+void parseArgs(int argc, char** argv, char** name, int* threads, double* tolerance){
+	int c, i, found;
+	while((c=getopt(argc, argv, "f:t:e:")) != -1){
+		switch(c){
+			case 'f':
+				*name = optarg;
+				break;
+			case 't':
+				*threads = atoi(optarg);
+				break;
+			case 'e':
+				*tolerance = atof(optarg);
+				break;
+			default:
+				printf("usage: %s [-f square|peak|sqrt|gauss] [-t threads] [-e tolerance]\n", argv[0]);
+				exit(1);
+		}
+	}
+	found = *name == NULL;
+	for(i=0;i<INTEGRANDS && !found;++i){
+		found = strcmp(*name, integrands[i].name) == 0;
+	}
+	if(!found || *threads < 1 || *tolerance <= 0.0){
+		printf("usage: %s [-f square|peak|sqrt|gauss] [-t threads] [-e tolerance]\n", argv[0]);
+		exit(1);
+	}
+}
@@ -1,49 +1,63 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "matrix_io.h"
  
 #define NUM_THREADS 4
-#define DIM 16
 
-//matrix
-int A[DIM][DIM];
+//size of the matrix, read from the input
+int dim;
+//matrix, dim x dim values row after row
+const int* A;
 //vector
-int x[DIM];
+int* x;
 //result
-int y[DIM];
+int* y;
 
 void *MVM(void *argument)
 {
 	int tid,i,j;
 	tid = *((int *) argument);
    	
-	//distribute work blockwise
-	int block = DIM/NUM_THREADS;
-	for(i=tid*block;i<(tid+1)*block;++i){
+	//distribute work blockwise, the first dim%NUM_THREADS threads own one more row
+	int block = dim/NUM_THREADS;
+	int first = tid*block+(tid < dim%NUM_THREADS ? tid : dim%NUM_THREADS);
+	int last = first+block+(tid < dim%NUM_THREADS);
+	for(i=first;i<last;++i){
 		y[i] = 0;
-		for(j=0;j<DIM;++j){
-			y[i] += A[i][j]*x[j];
+		for(j=0;j<dim;++j){
+			y[i] += A[(size_t)i*dim+j]*x[j];
 		}
 	}
  	
 	return NULL;
 }
  
-int main(void){
+/*
+ * to compile:
+ * gcc -O2 -o pthreadsMVM pthreadsMVM.c matrix_io.c -pthread
+ * to run, with mvm.txt or another text or binary matrix file (matrix_io.h):
+ * ./pthreadsMVM mvm.bin
+ */
+int main(int argc, char** argv){
 
 	pthread_t threads[NUM_THREADS];
 	int thread_args[NUM_THREADS];
-	int i,j;
-	/* read input */
-	FILE* input;
-		input =	fopen("mvm.txt", "r");
-		if(input == NULL) printf("Error reading Input\n");
-		for(i=0;i<DIM;++i){
-			for(j=0;j<DIM;++j){
-				fscanf(input, "%d", &A[i][j]);
-			}
-			x[i] = i+1;
-		}
+	int i;
+	matrix input;
+	/* read input: a text file is parsed by the threads, a binary file is mapped */
+	if(!matrix_load(argc > 1 ? argv[1] : "mvm.txt", MATRIX_INT32, NUM_THREADS, &input)) return 1;
+	if(input.rows != input.cols){
+		printf("the matrix must be square\n");
+		return 1;
+	}
+	dim = input.rows;
+	A = (const int*) input.data;
+	x = (int*) malloc(sizeof(int)*dim);
+	y = (int*) malloc(sizeof(int)*dim);
+	for(i=0;i<dim;++i){
+		x[i] = i+1;
+	}
 	/* create all threads */
 	for (i=0; i<NUM_THREADS; ++i) {
 		thread_args[i] = i;
@@ -55,9 +69,12 @@ int main(void){
 		pthread_join(threads[i], NULL);
 	}
 
-	for(i=0;i<DIM;++i){
+	for(i=0;i<dim;++i){
 		printf("%d\n", y[i]);
 	}
 
+	matrix_free(&input);
+	free(x);
+	free(y);
 	return 0;
 }
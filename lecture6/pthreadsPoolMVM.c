@@ -0,0 +1,190 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include "thread_pool.h"
+#include "mvm_kernel.h"
+
+/*
+ * Latency of small threaded matrix-vector products: many calls y = A x of a n x n matrix of doubles,
+ * the rows split in blocks among the threads (the first n%threads threads own one more row), with
+ * + create: pthread_create/pthread_join of the threads at every call, as pthreadsMVM.c
+ * + barrier: the pool of thread_pool.h, the threads sleep on a barrier between the calls
+ * + spin: the same pool, the threads poll a counter between the calls
+ * the calling thread computes the first block. With -p, the threads of every mode are pinned the same way,
+ * the created threads pin themselves before their block (it is part of the time of a call). The mean, median and smallest time of a call are reported:
+ * for small matrices, it is the time to start and wait for the threads.
+ */
+
+/* the ways to start the threads */
+typedef enum{
+	MODE_CREATE = 0,
+	MODE_BARRIER,
+	MODE_SPIN,
+	MODES
+} pool_mode;
+
+static const char* modeNames[MODES] = {"create", "barrier", "spin"};
+
+/* product shared by the threads */
+typedef struct{
+	const double *A, *x;
+	double* y;
+	int n;
+} mvm_call;
+
+/* argument of a created thread */
+typedef struct{
+	mvm_call* call;
+	int tid, threads;
+	int pin;		/* pinned as the threads of the pool */
+} created_thread;
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int* n, int* threads, int* calls, int* pin);
+/* product of the rows of a thread */
+void MVM(void* argument, int tid, int threads);
+void* createdMVM(void* argument);
+double now(void);
+int compareDoubles(const void* a, const void* b);
+
+/*
+ * to compile:
+ * gcc -O2 -march=native -o pthreadsPoolMVM pthreadsPoolMVM.c thread_pool.c mvm_kernel.c -pthread -lm
+ * to run, 100000 products of a 16 x 16 matrix with 4 pinned threads:
+ * ./pthreadsPoolMVM -n 16 -t 4 -i 100000 -p
+ */
+int main(int argc, char* argv[]){
+
+	int n = 16;
+	int threads = 4;
+	int calls = 10000;
+	int pin = 0;
+	int i, j, c, t, mode;
+	double *A, *x, *y, *reference, *times;
+	double time, total, error;
+	mvm_call call;
+	thread_pool pool;
+	pthread_t* handles;
+	created_thread* created;
+
+	parseArgs(argc, argv, &n, &threads, &calls, &pin);
+	A = mvm_aligned_alloc((size_t) n*n);
+	x = mvm_aligned_alloc(n);
+	y = mvm_aligned_alloc(n);
+	reference = mvm_aligned_alloc(n);
+	times = (double*) malloc(sizeof(double)*calls);
+	handles = (pthread_t*) malloc(sizeof(pthread_t)*threads);
+	created = (created_thread*) malloc(sizeof(created_thread)*threads);
+	for(i=0;i<n;++i){
+		for(j=0;j<n;++j){
+			A[(size_t)i*n+j] = i+j+1;
+		}
+		x[i] = i+1;
+	}
+	mvm_naive(A, x, reference, n, 0, n);
+	call.A = A;
+	call.x = x;
+	call.y = y;
+	call.n = n;
+
+	printf("matrix %d x %d, %d threads%s, %d calls\n", n, n, threads, pin ? " pinned" : "", calls);
+	printf("mode\t\tmean (us)\tmedian (us)\tmin (us)\terror\n");
+	for(mode=0;mode<MODES;++mode){
+		memset(y, 0, sizeof(double)*n);
+		if(mode != MODE_CREATE) pool_create(&pool, threads, mode == MODE_BARRIER ? POOL_BARRIER : POOL_SPIN, pin);
+		else if(pin) pool_pin(0);
+		total = 0.0;
+		for(c=0;c<calls;++c){
+			time = now();
+			if(mode == MODE_CREATE){
+				for(t=1;t<threads;++t){
+					created[t].call = &call;
+					created[t].tid = t;
+					created[t].threads = threads;
+					created[t].pin = pin;
+					pthread_create(&handles[t], NULL, createdMVM, &created[t]);
+				}
+				MVM(&call, 0, threads);
+				for(t=1;t<threads;++t){
+					pthread_join(handles[t], NULL);
+				}
+			}else{
+				pool_run(&pool, MVM, &call);
+			}
+			times[c] = now()-time;
+			total += times[c];
+		}
+		if(mode != MODE_CREATE) pool_destroy(&pool);
+		error = 0.0;
+		for(i=0;i<n;++i){
+			if(fabs(y[i]-reference[i]) > error) error = fabs(y[i]-reference[i]);
+		}
+		qsort(times, calls, sizeof(double), compareDoubles);
+		printf("%-12s\t%f\t%f\t%f\t%g\n", modeNames[mode], 1e6*total/calls, 1e6*times[calls/2], 1e6*times[0], error);
+	}
+
+	free(A);
+	free(x);
+	free(y);
+	free(reference);
+	free(times);
+	free(handles);
+	free(created);
+	return 0;
+}
+
+void MVM(void* argument, int tid, int threads){
+	mvm_call* call = (mvm_call*) argument;
+	int count = call->n/threads+(tid < call->n%threads);
+	int first = tid*(call->n/threads)+(tid < call->n%threads ? tid : call->n%threads);
+	if(count > 0) mvm_blocked(call->A, call->x, call->y, call->n, first, count);
+}
+
+void* createdMVM(void* argument){
+	created_thread* self = (created_thread*) argument;
+	if(self->pin) pool_pin(self->tid);
+	MVM(self->call, self->tid, self->threads);
+	return NULL;
+}
+
+double now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+int compareDoubles(const void* a, const void* b){
+	double u = *(const double*) a, v = *(const double*) b;
+	return u < v ? -1 : (u > v ? 1 : 0);
+}
+
+void parseArgs(int argc, char** argv, int* n, int* threads, int* calls, int* pin){
+	int c;
+	while((c=getopt(argc, argv, "n:t:i:p")) != -1){
+		switch(c){
+			case 'n':
+				*n = atoi(optarg);
+				break;
+			case 't':
+				*threads = atoi(optarg);
+				break;
+			case 'i':
+				*calls = atoi(optarg);
+				break;
+			case 'p':
+				*pin = 1;
+				break;
+			default:
+				printf("usage: %s [-n size] [-t threads] [-i calls] [-p]\n", argv[0]);
+				exit(1);
+		}
+	}
+	if(*n < 1 || *threads < 1 || *calls < 1){
+		printf("the arguments must be positive\n");
+		exit(1);
+	}
+}
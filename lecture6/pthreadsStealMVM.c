@@ -0,0 +1,268 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include "spmv_matrix.h"
+#include "work_steal.h"
+
+/*
+ * Threaded sparse matrix-vector products with rows of different costs, with pthreads:
+ * the rows are cut in chunks of the same number of rows, each thread gets the chunks of its block of rows
+ * (the static split of pthreadsMVM.c), then
+ * + static: each thread only computes its own chunks
+ * + stealing: a thread without chunks steals chunks from the deque of another thread (work_steal.h),
+ *   the victims are tried from a random one
+ * the matrix is a MatrixMarket file or a matrix with long rows in its first eighth, so the first threads
+ * have more work; with -w, thread 0 is also slowed down at each chunk, as by another program on its core.
+ * For each thread, the chunks of its own, the stolen chunks, the busy time and the idle time are reported.
+ */
+
+/* the schedules */
+typedef enum{
+	SCHEDULE_STATIC = 0,
+	SCHEDULE_STEALING,
+	SCHEDULES
+} steal_schedule;
+
+static const char* scheduleNames[SCHEDULES] = {"static", "stealing"};
+
+/* statistics of a thread, on its own cache line */
+typedef struct{
+	_Alignas(64) long own;
+	long stolen, aborts;
+	double busy;
+} thread_stats;
+
+/* shared by the threads */
+csr_matrix A;
+double *x, *y;
+int threads, iterations, chunkRows, chunks, delay;
+steal_schedule schedule;
+steal_deque* deques;
+thread_stats* stats;
+pthread_barrier_t barrier;
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, char** inputName, int* n, int* threads, int* iterations, int* chunkRows,
+	int* delay);
+/* matrix with rows of 256 values in its first eighth, of 8 values after */
+void skewedMatrix(csr_matrix* A, int n);
+/* the products of a thread */
+void* MVM(void* argument);
+double now(void);
+
+/*
+ * to compile:
+ * gcc -O2 -fopenmp-simd -o pthreadsStealMVM pthreadsStealMVM.c work_steal.c spmv_matrix.c -pthread -lm
+ * to run, 4 threads, chunks of 64 rows, thread 0 slowed down by 20 us per chunk:
+ * ./pthreadsStealMVM -t 4 -c 64 -w 20
+ */
+int main(int argc, char* argv[]){
+
+	char* inputName = NULL;
+	int n = 200000;
+	int i, t;
+	int* ids;
+	double *reference, time, error, mean, max;
+	pthread_t* handles;
+
+	threads = 4;
+	iterations = 20;
+	chunkRows = 64;
+	delay = 0;
+	parseArgs(argc, argv, &inputName, &n, &threads, &iterations, &chunkRows, &delay);
+	if(inputName != NULL){
+		if(!csr_read_matrix_market(inputName, &A)) return 1;
+	}else{
+		skewedMatrix(&A, n);
+	}
+	x = (double*) malloc(sizeof(double)*A.cols);
+	y = (double*) malloc(sizeof(double)*A.rows);
+	reference = (double*) malloc(sizeof(double)*A.rows);
+	for(i=0;i<A.cols;++i){
+		x[i] = 1.0/(1+i%5);
+	}
+	csr_multiply_rows(&A, x, reference, 0, A.rows);
+	chunks = (A.rows+chunkRows-1)/chunkRows;
+
+	if(posix_memalign((void**) &deques, 64, sizeof(steal_deque)*threads) != 0
+		|| posix_memalign((void**) &stats, 64, sizeof(thread_stats)*threads) != 0){
+		printf("not enough memory\n");
+		return 1;
+	}
+	handles = (pthread_t*) malloc(sizeof(pthread_t)*threads);
+	ids = (int*) malloc(sizeof(int)*threads);
+	pthread_barrier_init(&barrier, NULL, threads);
+
+	printf("matrix %d x %d, %ld nonzeros, %d chunks of %d rows, %d threads", A.rows, A.cols, A.nnz, chunks,
+		chunkRows, threads);
+	if(delay > 0) printf(", thread 0 slowed down by %d us per chunk", delay);
+	printf("\n");
+	for(schedule=0;schedule<SCHEDULES;++schedule){
+		memset(y, 0, sizeof(double)*A.rows);
+		memset(stats, 0, sizeof(thread_stats)*threads);
+		time = now();
+		for(t=0;t<threads;++t){
+			ids[t] = t;
+			pthread_create(&handles[t], NULL, MVM, &ids[t]);
+		}
+		for(t=0;t<threads;++t){
+			pthread_join(handles[t], NULL);
+		}
+		time = now()-time;
+		error = 0.0;
+		for(i=0;i<A.rows;++i){
+			double e = fabs(y[i]-reference[i]);
+			if(e > error) error = e;
+		}
+		mean = max = 0.0;
+		for(t=0;t<threads;++t){
+			mean += stats[t].busy/threads;
+			if(stats[t].busy > max) max = stats[t].busy;
+		}
+		printf("\n%s: time/product %f (us), busy imbalance %f, error %g\n", scheduleNames[schedule],
+			1e6*time/iterations, mean > 0.0 ? max/mean : 1.0, error);
+		printf("thread\town chunks\tstolen chunks\tlost steals\tbusy/product (us)\tidle/product (us)\n");
+		for(t=0;t<threads;++t){
+			printf("%d\t%ld\t\t%ld\t\t%ld\t\t%f\t\t%f\n", t, stats[t].own/iterations, stats[t].stolen/iterations,
+				stats[t].aborts/iterations, 1e6*stats[t].busy/iterations, 1e6*(time-stats[t].busy)/iterations);
+		}
+	}
+
+	pthread_barrier_destroy(&barrier);
+	csr_free(&A);
+	free(x);
+	free(y);
+	free(reference);
+	free(deques);
+	free(stats);
+	free(handles);
+	free(ids);
+	return 0;
+}
+
+/* the rows of a chunk, and the slow down of thread 0 */
+static void runChunk(long chunk, int tid){
+	int first = chunk*chunkRows;
+	int last = first+chunkRows < A.rows ? first+chunkRows : A.rows;
+	double start = now();
+	csr_multiply_rows(&A, x, y, first, last);
+	if(tid == 0 && delay > 0){
+		while(now()-start < 1e-6*delay);
+	}
+	stats[tid].busy += now()-start;
+}
+
+void* MVM(void* argument){
+	int tid = *((int*) argument);
+	int it, k, victim;
+	long chunk;
+	unsigned int seed = 12345u+tid;
+	int found;
+	for(it=0;it<iterations;++it){
+		/*
+		 * the chunks of the block of rows of the thread
+		 */
+		steal_deque_reset(&deques[tid], (long) chunks*tid/threads, (long) chunks*(tid+1)/threads);
+		pthread_barrier_wait(&barrier);
+		while((chunk = steal_pop(&deques[tid])) != STEAL_EMPTY){
+			runChunk(chunk, tid);
+			++stats[tid].own;
+		}
+		/*
+		 * no chunk is ever added: when a round over all the other deques finds them empty, the product is done
+		 */
+		while(schedule == SCHEDULE_STEALING && threads > 1){
+			found = 0;
+			seed = seed*1103515245u+12345u;
+			victim = (seed >> 16)%threads;
+			for(k=0;k<threads;++k){
+				int v = (victim+k)%threads;
+				if(v == tid) continue;
+				chunk = steal_take(&deques[v]);
+				if(chunk == STEAL_ABORT){
+					++stats[tid].aborts;
+					found = 1;
+				}else if(chunk != STEAL_EMPTY){
+					runChunk(chunk, tid);
+					++stats[tid].stolen;
+					found = 1;
+					break;
+				}
+			}
+			if(!found) break;
+		}
+		pthread_barrier_wait(&barrier);
+	}
+	return NULL;
+}
+
+void skewedMatrix(csr_matrix* A, int n){
+	int i, k, length;
+	long nnz = 0;
+	A->rows = A->cols = n;
+	A->rowPtr = (long*) malloc(sizeof(long)*(n+1));
+	A->rowPtr[0] = 0;
+	for(i=0;i<n;++i){
+		length = i < n/8 ? 256 : 8;
+		if(length > n) length = n;
+		A->rowPtr[i+1] = A->rowPtr[i]+length;
+	}
+	A->nnz = A->rowPtr[n];
+	A->col = (int*) malloc(sizeof(int)*A->nnz);
+	A->val = (double*) malloc(sizeof(double)*A->nnz);
+	/*
+	 * the columns of a row are spread over the matrix, in increasing order
+	 */
+	for(i=0;i<n;++i){
+		length = A->rowPtr[i+1]-A->rowPtr[i];
+		for(k=0;k<length;++k){
+			A->col[nnz] = (int) (((long) k*n/length+i%(n/length)) % n);
+			A->val[nnz++] = 1.0/(1+(i+k)%3);
+		}
+	}
+}
+
+double now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+void parseArgs(int argc, char** argv, char** inputName, int* n, int* threads, int* iterations, int* chunkRows,
+	int* delay){
+	int c;
+	while((c=getopt(argc, argv, "f:n:t:i:c:w:")) != -1){
+		switch(c){
+			case 'f':
+				*inputName = optarg;
+				break;
+			case 'n':
+				*n = atoi(optarg);
+				break;
+			case 't':
+				*threads = atoi(optarg);
+				break;
+			case 'i':
+				*iterations = atoi(optarg);
+				break;
+			case 'c':
+				*chunkRows = atoi(optarg);
+				break;
+			case 'w':
+				*delay = atoi(optarg);
+				break;
+			default:
+				printf("usage: %s [-f matrix.mtx | -n rows] [-t threads] [-i iterations] [-c chunk rows] [-w delay (us)]\n",
+					argv[0]);
+				exit(1);
+		}
+	}
+	if(*n < 1 || *threads < 1 || *iterations < 1 || *chunkRows < 1 || *delay < 0){
+		printf("the arguments must be positive\n");
+		exit(1);
+	}
+}
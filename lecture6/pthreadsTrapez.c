@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include "reduction.h"
 
 /* The global variables are shared among all the threads. */
 int    thread_count = 4;
@@ -16,10 +17,17 @@ int 	flag;
 sem_t 	sem;
 pthread_mutex_t mutex;
 
+/* lock-free variables (reduction.h) */
+reduction_slot*	slots;
+reduction_tree	tree;
+
 /* global result */
 double	total_flag = 0.0;
 double  total_sem = 0.0;
 double 	total_mutex = 0.0;
+_Atomic double	total_atomic = 0.0;
+double	total_slots = 0.0;
+double	total_tree = 0.0;
 
 void *Thread_work(void* rank);
 /* Calculate local integral  */
@@ -42,6 +50,8 @@ int main(int argc, char** argv) {
     flag = 0;
     pthread_mutex_init(&mutex, NULL);
     sem_init(&sem, 0, 1);
+    slots = reduction_slots(thread_count);
+    reduction_tree_init(&tree, thread_count);
 	
     /* Start the threads. */
     for (i = 0; i < thread_count; i++) {
@@ -53,14 +63,21 @@ int main(int argc, char** argv) {
     for (i = 0; i < thread_count; i++) {
         pthread_join(thread_handles[i], NULL);
     }
+    /* the slots are added once all the threads are done */
+    total_slots = reduction_slots_sum(slots, thread_count);
     
     printf("The function f(x) = x² , in the interval [%.4f, %.4f], has an estimate area of:\n", a,b);
     printf("busy waiting: %f\n", total_flag);
     printf("mutex: %f\n", total_mutex);
     printf("semaphore: %f\n", total_sem);
+    printf("atomic: %f\n", (double) total_atomic);
+    printf("padded slots: %f\n", total_slots);
+    printf("tree: %f\n", total_tree);
 	
     pthread_mutex_destroy(&mutex);
     sem_destroy(&sem);
+    free(slots);
+    reduction_tree_free(&tree);
     free(thread_handles);
 	
     return 0;
@@ -89,6 +106,7 @@ void *Thread_work(void* rank) {
     //	   total_flag  == busy waiting
     // 	   total_mutex == mutex
     //     total_sem   == semaphore
+    // (3) without a lock (reduction.h): total_atomic, total_slots, total_tree
 
     /* busy waiting */ 
     while(flag != my_rank);
@@ -105,6 +123,16 @@ void *Thread_work(void* rank) {
     total_mutex += my_int;
     pthread_mutex_unlock(&mutex);
 
+    /* atomic: compare-and-swap loop, no lock */
+    reduction_atomic_add(&total_atomic, my_int);
+
+    /* padded slots: each thread writes its own cache line, main adds them after the join */
+    slots[my_rank].value = my_int;
+
+    /* tree: log2(thread_count) steps, thread 0 gets the total */
+    double sum = reduction_tree_sum(&tree, my_rank, my_int, 1);
+    if(my_rank == 0) total_tree = sum;
+
     /**********************/
     /* YOUR TASK END HERE */
     /**********************/
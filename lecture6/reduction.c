@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "reduction.h"
+
+long reduction_atomic_add(_Atomic double* total, double value){
+	long failed = 0;
+	double old = atomic_load_explicit(total, memory_order_relaxed);
+	/*
+	 * old is updated by a failed compare-and-swap
+	 */
+	while(!atomic_compare_exchange_weak_explicit(total, &old, old+value, memory_order_relaxed, memory_order_relaxed)){
+		++failed;
+	}
+	return failed;
+}
+
+reduction_slot* reduction_slots(int threads){
+	reduction_slot* slots = NULL;
+	if(posix_memalign((void**) &slots, 64, sizeof(reduction_slot)*threads) != 0) return NULL;
+	memset(slots, 0, sizeof(reduction_slot)*threads);
+	return slots;
+}
+
+double reduction_slots_sum(const reduction_slot* slots, int threads){
+	int t;
+	double sum = 0.0;
+	for(t=0;t<threads;++t){
+		sum += slots[t].value;
+	}
+	return sum;
+}
+
+void reduction_tree_init(reduction_tree* tree, int threads){
+	int t;
+	tree->threads = threads;
+	tree->values = reduction_slots(threads);
+	if(posix_memalign((void**) &tree->ready, 64, sizeof(reduction_flag)*threads) != 0) tree->ready = NULL;
+	for(t=0;t<threads;++t){
+		atomic_init(&tree->ready[t].round, 0);
+	}
+	atomic_init(&tree->done.round, 0);
+	tree->total = 0.0;
+}
+
+void reduction_tree_free(reduction_tree* tree){
+	free(tree->values);
+	free(tree->ready);
+}
+
+/* polls until the flag reaches round */
+static void waitFor(reduction_flag* flag, long round){
+	int spins = 0;
+	while(atomic_load_explicit(&flag->round, memory_order_acquire) < round){
+		if(++spins > REDUCTION_SPINS) sched_yield();
+	}
+}
+
+double reduction_tree_sum(reduction_tree* tree, int tid, double value, long round){
+	int stride, partner;
+	for(stride=1;stride<tree->threads;stride*=2){
+		if(tid%(2*stride) != 0){
+			/*
+			 * the partial sum goes to the partner tid-stride, then the thread waits for the total
+			 */
+			tree->values[tid].value = value;
+			atomic_store_explicit(&tree->ready[tid].round, round, memory_order_release);
+			waitFor(&tree->done, round);
+			return tree->total;
+		}
+		partner = tid+stride;
+		if(partner < tree->threads){
+			waitFor(&tree->ready[partner], round);
+			value += tree->values[partner].value;
+		}
+	}
+	/*
+	 * thread 0
+	 */
+	tree->total = value;
+	atomic_store_explicit(&tree->done.round, round, memory_order_release);
+	return value;
+}
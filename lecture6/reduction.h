@@ -0,0 +1,46 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+#include <stdatomic.h>
+
+/*
+ * Sums of the values of the threads without a lock:
+ * + reduction_atomic_add: a shared _Atomic double, updated with a compare-and-swap loop
+ *   (there is no atomic addition of doubles), the threads retry when another one changed it first
+ * + reduction_slots: one slot per thread on its own cache line, written without any synchronization
+ *   and added by one thread once all the threads are done (after a join or a barrier)
+ * + reduction_tree: the threads are paired as the leaves of a binary tree: at each level, a thread
+ *   waits for the flag of its partner and adds its value, so the sum takes log2(threads) steps and the
+ *   threads only wait for their partners; thread 0 then releases all the threads with the total,
+ *   a barrier and a reduction at once. The calls of a tree are numbered, so it can be used again
+ *   (the waits poll, with sched_yield after REDUCTION_SPINS polls)
+ */
+#define REDUCTION_SPINS 100
+
+/* a value alone on its cache line */
+typedef struct{
+	_Alignas(64) double value;
+} reduction_slot;
+
+typedef struct{
+	_Alignas(64) atomic_long round;
+} reduction_flag;
+
+typedef struct{
+	int threads;
+	reduction_slot* values;		/* partial sums */
+	reduction_flag* ready;		/* call for which the partial sum of a thread is ready */
+	reduction_flag done;		/* last call whose total is known */
+	double total;
+} reduction_tree;
+
+/* adds value to total, returns the number of failed compare-and-swap */
+long reduction_atomic_add(_Atomic double* total, double value);
+/* threads slots set to 0, freed with free */
+reduction_slot* reduction_slots(int threads);
+double reduction_slots_sum(const reduction_slot* slots, int threads);
+void reduction_tree_init(reduction_tree* tree, int threads);
+void reduction_tree_free(reduction_tree* tree);
+/* called by the threads 0..threads-1 with the number of the call (1, 2, ...), returns the total to all */
+double reduction_tree_sum(reduction_tree* tree, int tid, double value, long round);
+
+#endif
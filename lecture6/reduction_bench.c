@@ -0,0 +1,226 @@
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+#include <getopt.h>
+#include "reduction.h"
+
+/*
+ * Latency of repeated sums of one value per thread, known by all the threads at the end of each round
+ * (as the sums of pthreadsTrapez.c, but many times and for 1, 2, 4, ... threads):
+ * + mutex, semaphore: the shared total updated under a pthread mutex or a semaphore, then a barrier
+ * + turnstile: the busy-wait flag of pthreadsTrapez.c, the threads add in the order of their rank, then a barrier
+ * + atomic: the shared total updated with a compare-and-swap loop (reduction.h), then a barrier
+ * + slots: each thread writes its slot on its own cache line, a barrier, then each thread adds the slots
+ * + tree: the tree reduction of reduction.h, which is also the barrier
+ * the shared totals of the rounds are used in turn (3 of them): in round r, the total of round r+1 is set to 0,
+ * its last reads were in round r-2, before the barrier of round r-1.
+ * The time per round and the contention per round are reported:
+ * the failed trylock for the mutex and the semaphore, the failed compare-and-swap for atomic,
+ * and the waits for the turn of the thread for the turnstile. The rounds are timed by thread 0
+ * between 2 barriers, without the creation of the threads.
+ */
+
+/* the reductions */
+typedef enum{
+	MODE_MUTEX = 0,
+	MODE_SEMAPHORE,
+	MODE_TURNSTILE,
+	MODE_ATOMIC,
+	MODE_SLOTS,
+	MODE_TREE,
+	MODES
+} reduction_mode;
+
+static const char* modeNames[MODES] = {"mutex", "semaphore", "turnstile", "atomic", "slots", "tree"};
+
+/* shared by the threads */
+int threads, rounds;
+reduction_mode mode;
+pthread_barrier_t barrier;
+pthread_mutex_t mutex;
+sem_t sem;
+atomic_int flag;
+double totals[3];
+_Atomic double atomicTotals[3];
+reduction_slot* slots[2];
+reduction_tree tree;
+reduction_slot* contention;	/* per thread */
+long errors;
+double elapsed;
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int* maxThreads, int* rounds);
+/* the rounds of a thread */
+void* reduce(void* argument);
+double now(void);
+
+/*
+ * to compile:
+ * gcc -O2 -o reduction_bench reduction_bench.c reduction.c -pthread
+ * to run, 1 to 128 threads, 1000 rounds:
+ * ./reduction_bench -t 128 -r 1000
+ */
+int main(int argc, char* argv[]){
+
+	int maxThreads = 16;
+	int t;
+	int* ids;
+	pthread_t* handles;
+
+	rounds = 1000;
+	parseArgs(argc, argv, &maxThreads, &rounds);
+	handles = (pthread_t*) malloc(sizeof(pthread_t)*maxThreads);
+	ids = (int*) malloc(sizeof(int)*maxThreads);
+	pthread_mutex_init(&mutex, NULL);
+	sem_init(&sem, 0, 1);
+
+	printf("%d rounds, time per round (us) and contention per round\n", rounds);
+	printf("threads");
+	for(mode=0;mode<MODES;++mode){
+		printf("\t%-9s\t", modeNames[mode]);
+	}
+	printf("\n");
+	for(threads=1;;threads=2*threads < maxThreads ? 2*threads : maxThreads){
+		printf("%d", threads);
+		for(mode=0;mode<MODES;++mode){
+			pthread_barrier_init(&barrier, NULL, threads);
+			atomic_init(&flag, 0);
+			totals[0] = totals[1] = totals[2] = 0.0;
+			atomic_init(&atomicTotals[0], 0.0);
+			atomic_init(&atomicTotals[1], 0.0);
+			atomic_init(&atomicTotals[2], 0.0);
+			slots[0] = reduction_slots(threads);
+			slots[1] = reduction_slots(threads);
+			contention = reduction_slots(threads);
+			reduction_tree_init(&tree, threads);
+			errors = 0;
+			for(t=0;t<threads;++t){
+				ids[t] = t;
+				pthread_create(&handles[t], NULL, reduce, &ids[t]);
+			}
+			for(t=0;t<threads;++t){
+				pthread_join(handles[t], NULL);
+			}
+			printf("\t%f %-8.2f", 1e6*elapsed/rounds, reduction_slots_sum(contention, threads)/rounds);
+			if(errors > 0) printf("(%ld wrong sums)", errors);
+			fflush(stdout);
+			pthread_barrier_destroy(&barrier);
+			free(slots[0]);
+			free(slots[1]);
+			free(contention);
+			reduction_tree_free(&tree);
+		}
+		printf("\n");
+		if(threads == maxThreads) break;
+	}
+
+	pthread_mutex_destroy(&mutex);
+	sem_destroy(&sem);
+	free(handles);
+	free(ids);
+	return 0;
+}
+
+void* reduce(void* argument){
+	int tid = *((int*) argument);
+	int r, t, spins;
+	double value = tid+1, total = 0.0;
+	double expected = 0.5*threads*(threads+1);
+	long waits = 0;
+	pthread_barrier_wait(&barrier);
+	if(tid == 0) elapsed = now();
+	for(r=0;r<rounds;++r){
+		int current = r%3;
+		/*
+		 * the total of the next round, the slot last read in round r-2: all the threads have read it
+		 * before the barrier of round r-1
+		 */
+		if(tid == 0){
+			totals[(r+1)%3] = 0.0;
+			atomic_store_explicit(&atomicTotals[(r+1)%3], 0.0, memory_order_relaxed);
+		}
+		switch(mode){
+			case MODE_MUTEX:
+				if(pthread_mutex_trylock(&mutex) != 0){
+					++waits;
+					pthread_mutex_lock(&mutex);
+				}
+				totals[current] += value;
+				pthread_mutex_unlock(&mutex);
+				pthread_barrier_wait(&barrier);
+				total = totals[current];
+				break;
+			case MODE_SEMAPHORE:
+				if(sem_trywait(&sem) != 0){
+					++waits;
+					sem_wait(&sem);
+				}
+				totals[current] += value;
+				sem_post(&sem);
+				pthread_barrier_wait(&barrier);
+				total = totals[current];
+				break;
+			case MODE_TURNSTILE:
+				spins = 0;
+				if(atomic_load_explicit(&flag, memory_order_acquire) != tid) ++waits;
+				while(atomic_load_explicit(&flag, memory_order_acquire) != tid){
+					if(++spins > REDUCTION_SPINS) sched_yield();
+				}
+				totals[current] += value;
+				atomic_store_explicit(&flag, (tid+1)%threads, memory_order_release);
+				pthread_barrier_wait(&barrier);
+				total = totals[current];
+				break;
+			case MODE_ATOMIC:
+				waits += reduction_atomic_add(&atomicTotals[current], value);
+				pthread_barrier_wait(&barrier);
+				total = atomic_load_explicit(&atomicTotals[current], memory_order_relaxed);
+				break;
+			case MODE_SLOTS:
+				slots[r%2][tid].value = value;
+				pthread_barrier_wait(&barrier);
+				total = 0.0;
+				for(t=0;t<threads;++t){
+					total += slots[r%2][t].value;
+				}
+				break;
+			default:
+				total = reduction_tree_sum(&tree, tid, value, r+1);
+		}
+		if(tid == 0 && total != expected) ++errors;
+	}
+	pthread_barrier_wait(&barrier);
+	if(tid == 0) elapsed = now()-elapsed;
+	contention[tid].value = waits;
+	return NULL;
+}
+
+double now(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+void parseArgs(int argc, char** argv, int* maxThreads, int* rounds){
+	int c;
+	while((c=getopt(argc, argv, "t:r:")) != -1){
+		switch(c){
+			case 't':
+				*maxThreads = atoi(optarg);
+				break;
+			case 'r':
+				*rounds = atoi(optarg);
+				break;
+			default:
+				printf("usage: %s [-t max threads] [-r rounds]\n", argv[0]);
+				exit(1);
+		}
+	}
+	if(*maxThreads < 1 || *rounds < 1){
+		printf("the arguments must be positive\n");
+		exit(1);
+	}
+}
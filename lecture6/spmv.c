@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <omp.h>
+#include "spmv_matrix.h"
+#include "spmv_omp.h"
+
+/*
+ * Threaded sparse matrix-vector products (OpenMP) of a MatrixMarket matrix or of the 5 point Laplacian,
+ * compared with the dense product of the same matrix (pthreadsMVM.c) when it has at most SPMV_DENSE_LIMIT rows:
+ * + dense: all the values of the matrix, the rows split evenly among the threads
+ * + csr with the rows split evenly: the threads with the longest rows wait for the others
+ * + csr with the rows split by nonzeros: the same work for every thread
+ * + sell: SELL-C-sigma, the chunks split by stored values
+ * all the products give GFLOP/s for the 2 nnz useful operations (the dense product does n^2 of them).
+ */
+
+/* the products */
+typedef enum{
+	KERNEL_DENSE = 0,
+	KERNEL_CSR_ROWS,
+	KERNEL_CSR_NNZ,
+	KERNEL_SELL,
+	KERNELS
+} spmv_kernel;
+
+static const char* kernelNames[KERNELS] = {"dense", "csr", "csr", "sell"};
+static const char* partitionNames[KERNELS] = {"rows", "rows", "nonzeros", "nonzeros"};
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, char** inputName, int* gridSize, int* threads, int* iterations, int* C, int* sigma);
+/* largest ratio of the nonzeros of a block of a partition to the mean */
+double imbalance(const long* prefix, int parts, const int* first);
+/* largest relative difference of 2 vectors */
+double difference(const double* y, const double* reference, int n);
+
+/*
+ * to compile:
+ * gcc -O2 -fopenmp -o spmv spmv.c spmv_matrix.c spmv_omp.c -lm
+ * to run, the Laplacian of a 1000 x 1000 grid with 4 threads:
+ * ./spmv -g 1000 -t 4
+ * a MatrixMarket file, SELL-8-256:
+ * ./spmv -f matrix.mtx -t 4 -C 8 -s 256
+ */
+int main(int argc, char* argv[]){
+
+	char* inputName = NULL;
+	int gridSize = 512;
+	int threads = omp_get_max_threads();
+	int iterations = 100;
+	int C = 8, sigma = 256;
+	int i, k, kernel;
+	csr_matrix A;
+	sell_matrix S;
+	double *x, *y, *reference, *dense = NULL;
+	double time, partitionImbalance;
+	int *rowsFirst, *nnzFirst, *chunkFirst;
+
+	parseArgs(argc, argv, &inputName, &gridSize, &threads, &iterations, &C, &sigma);
+	if(inputName != NULL){
+		if(!csr_read_matrix_market(inputName, &A)) return 1;
+	}else{
+		csr_laplacian(&A, gridSize);
+	}
+	sell_from_csr(&S, &A, C, sigma);
+	x = (double*) malloc(sizeof(double)*A.cols);
+	y = (double*) malloc(sizeof(double)*A.rows);
+	reference = (double*) malloc(sizeof(double)*A.rows);
+	for(i=0;i<A.cols;++i){
+		x[i] = 1.0/(1+i%5);
+	}
+	csr_multiply_rows(&A, x, reference, 0, A.rows);
+
+	rowsFirst = (int*) malloc(sizeof(int)*(threads+1));
+	nnzFirst = (int*) malloc(sizeof(int)*(threads+1));
+	chunkFirst = (int*) malloc(sizeof(int)*(threads+1));
+	csr_partition_rows(&A, threads, rowsFirst);
+	csr_partition_nnz(&A, threads, nnzFirst);
+	sell_partition_nnz(&S, threads, chunkFirst);
+	if((long) A.rows*A.cols <= (long) SPMV_DENSE_LIMIT*SPMV_DENSE_LIMIT){
+		dense = (double*) calloc((size_t) A.rows*A.cols, sizeof(double));
+		for(i=0;i<A.rows;++i){
+			long j;
+			for(j=A.rowPtr[i];j<A.rowPtr[i+1];++j){
+				dense[(size_t)i*A.cols+A.col[j]] = A.val[j];
+			}
+		}
+	}
+
+	printf("matrix %d x %d, %ld nonzeros, %d threads, SELL-%d-%d with %.1f%% padding\n", A.rows, A.cols, A.nnz,
+		threads, S.C, S.sigma, 100.0*(S.paddedNnz-S.nnz)/(S.paddedNnz > 0 ? S.paddedNnz : 1));
+	printf("kernel\tpartition\timbalance\ttime/product (us)\tGFLOP/s\t\terror\n");
+	for(kernel=0;kernel<KERNELS;++kernel){
+		if(kernel == KERNEL_DENSE && dense == NULL) continue;
+		memset(y, 0, sizeof(double)*A.rows);
+		time = omp_get_wtime();
+		for(k=0;k<iterations;++k){
+			switch(kernel){
+				case KERNEL_DENSE:
+					dense_multiply_omp(dense, x, y, A.rows, A.cols, threads);
+					break;
+				case KERNEL_CSR_ROWS:
+					csr_multiply_omp(&A, x, y, threads, rowsFirst);
+					break;
+				case KERNEL_CSR_NNZ:
+					csr_multiply_omp(&A, x, y, threads, nnzFirst);
+					break;
+				default:
+					sell_multiply_omp(&S, x, y, threads, chunkFirst);
+			}
+		}
+		time = omp_get_wtime()-time;
+		switch(kernel){
+			case KERNEL_DENSE:
+				/*
+				 * every row of the dense matrix has the same work
+				 */
+				partitionImbalance = 0.0;
+				for(i=0;i<threads;++i){
+					if(rowsFirst[i+1]-rowsFirst[i] > partitionImbalance) partitionImbalance = rowsFirst[i+1]-rowsFirst[i];
+				}
+				partitionImbalance *= (double) threads/A.rows;
+				break;
+			case KERNEL_CSR_ROWS:
+				partitionImbalance = imbalance(A.rowPtr, threads, rowsFirst);
+				break;
+			case KERNEL_CSR_NNZ:
+				partitionImbalance = imbalance(A.rowPtr, threads, nnzFirst);
+				break;
+			default:
+				partitionImbalance = imbalance(S.chunkPtr, threads, chunkFirst);
+		}
+		printf("%s\t%-9s\t%f\t%f\t\t%f\t%g\n", kernelNames[kernel], partitionNames[kernel], partitionImbalance,
+			1e6*time/iterations, 2.0*A.nnz*iterations/time/1e9, difference(y, reference, A.rows));
+	}
+
+	csr_free(&A);
+	sell_free(&S);
+	free(x);
+	free(y);
+	free(reference);
+	free(dense);
+	free(rowsFirst);
+	free(nnzFirst);
+	free(chunkFirst);
+	return 0;
+}
+
+double imbalance(const long* prefix, int parts, const int* first){
+	int p;
+	long max = 0, blockNnz;
+	for(p=0;p<parts;++p){
+		blockNnz = prefix[first[p+1]]-prefix[first[p]];
+		if(blockNnz > max) max = blockNnz;
+	}
+	return prefix[first[parts]] > 0 ? (double) max*parts/prefix[first[parts]] : 1.0;
+}
+
+double difference(const double* y, const double* reference, int n){
+	int i;
+	double error, maxError = 0.0;
+	for(i=0;i<n;++i){
+		error = fabs(y[i]-reference[i])/(fabs(reference[i]) > 1.0 ? fabs(reference[i]) : 1.0);
+		if(error > maxError) maxError = error;
+	}
+	return maxError;
+}
+
+void parseArgs(int argc, char** argv, char** inputName, int* gridSize, int* threads, int* iterations, int* C, int* sigma){
+	int c;
+	while((c=getopt(argc, argv, "f:g:t:i:C:s:")) != -1){
+		switch(c){
+			case 'f':
+				*inputName = optarg;
+				break;
+			case 'g':
+				*gridSize = atoi(optarg);
+				break;
+			case 't':
+				*threads = atoi(optarg);
+				break;
+			case 'i':
+				*iterations = atoi(optarg);
+				break;
+			case 'C':
+				*C = atoi(optarg);
+				break;
+			case 's':
+				*sigma = atoi(optarg);
+				break;
+			default:
+				printf("usage: %s [-f matrix.mtx | -g gridSize] [-t threads] [-i iterations] [-C chunk] [-s sigma]\n", argv[0]);
+				exit(1);
+		}
+	}
+	if(*gridSize < 1 || *threads < 1 || *iterations < 1 || *C < 1 || *C > SELL_MAX_C || *sigma < 1){
+		printf("the arguments must be positive, the chunk at most %d\n", SELL_MAX_C);
+		exit(1);
+	}
+}
@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "spmv_halo.h"
+
+static int compareInts(const void* a, const void* b){
+	int i = *(const int*) a, j = *(const int*) b;
+	return i < j ? -1 : (i > j ? 1 : 0);
+}
+
+/* process owning a column, first has numprocs+1 values */
+static int owner(const int* first, int numprocs, int col){
+	int low = 0, high = numprocs-1, middle;
+	while(low < high){
+		middle = (low+high+1)/2;
+		if(first[middle] <= col) low = middle;
+		else high = middle-1;
+	}
+	return low;
+}
+
+/* position of a column in the sorted halo */
+static int haloPosition(const spmv_halo* h, int col){
+	int* found = (int*) bsearch(&col, h->haloCols, h->haloSize, sizeof(int), compareInts);
+	return (int) (found-h->haloCols);
+}
+
+/* empty CSR matrix of rows rows, for the split of the local matrix */
+static void csrInit(csr_matrix* A, int rows, int cols, long nnz){
+	A->rows = rows;
+	A->cols = cols;
+	A->nnz = nnz;
+	A->rowPtr = (long*) malloc(sizeof(long)*(rows+1));
+	A->col = (int*) malloc(sizeof(int)*(nnz > 0 ? nnz : 1));
+	A->val = (double*) malloc(sizeof(double)*(nnz > 0 ? nnz : 1));
+	A->rowPtr[0] = 0;
+}
+
+void spmv_halo_create(spmv_halo* h, MPI_Comm comm, const csr_matrix* local, const int* first){
+	int myid, numprocs, p, i, count, col;
+	int myFirst, myLast;
+	long k, diagNnz = 0, offdNnz = 0;
+	int *needed, *allRecvCounts, *allSendCounts, *allRecvDispls, *allSendDispls, *sendCols;
+
+	MPI_Comm_rank(comm, &myid);
+	MPI_Comm_size(comm, &numprocs);
+	myFirst = first[myid];
+	myLast = first[myid+1];
+	h->comm = comm;
+	h->localRows = local->rows;
+
+	/*
+	 * the columns owned by other processes, sorted without duplicates
+	 */
+	needed = (int*) malloc(sizeof(int)*(local->nnz > 0 ? local->nnz : 1));
+	count = 0;
+	for(k=0;k<local->nnz;++k){
+		col = local->col[k];
+		if(col < myFirst || col >= myLast){
+			needed[count++] = col;
+			++offdNnz;
+		}else{
+			++diagNnz;
+		}
+	}
+	qsort(needed, count, sizeof(int), compareInts);
+	h->haloSize = 0;
+	for(i=0;i<count;++i){
+		if(h->haloSize == 0 || needed[i] != needed[h->haloSize-1]) needed[h->haloSize++] = needed[i];
+	}
+	h->haloCols = (int*) malloc(sizeof(int)*(h->haloSize > 0 ? h->haloSize : 1));
+	memcpy(h->haloCols, needed, sizeof(int)*h->haloSize);
+	free(needed);
+
+	/*
+	 * values received from each process (the halo is sorted by owner), and the values to send
+	 */
+	allRecvCounts = (int*) calloc(numprocs, sizeof(int));
+	allSendCounts = (int*) malloc(sizeof(int)*numprocs);
+	allRecvDispls = (int*) malloc(sizeof(int)*numprocs);
+	allSendDispls = (int*) malloc(sizeof(int)*numprocs);
+	for(i=0;i<h->haloSize;++i){
+		++allRecvCounts[owner(first, numprocs, h->haloCols[i])];
+	}
+	MPI_Alltoall(allRecvCounts, 1, MPI_INT, allSendCounts, 1, MPI_INT, comm);
+	allRecvDispls[0] = allSendDispls[0] = 0;
+	for(p=1;p<numprocs;++p){
+		allRecvDispls[p] = allRecvDispls[p-1]+allRecvCounts[p-1];
+		allSendDispls[p] = allSendDispls[p-1]+allSendCounts[p-1];
+	}
+	h->sendSize = allSendDispls[numprocs-1]+allSendCounts[numprocs-1];
+	sendCols = (int*) malloc(sizeof(int)*(h->sendSize > 0 ? h->sendSize : 1));
+	MPI_Alltoallv(h->haloCols, allRecvCounts, allRecvDispls, MPI_INT, sendCols, allSendCounts, allSendDispls, MPI_INT, comm);
+	h->sendIndex = (int*) malloc(sizeof(int)*(h->sendSize > 0 ? h->sendSize : 1));
+	for(i=0;i<h->sendSize;++i){
+		h->sendIndex[i] = sendCols[i]-myFirst;
+	}
+	h->sendBuffer = (double*) malloc(sizeof(double)*(h->sendSize > 0 ? h->sendSize : 1));
+	free(sendCols);
+
+	/*
+	 * only the neighbors are kept
+	 */
+	h->recvRanks = (int*) malloc(sizeof(int)*numprocs);
+	h->recvCounts = (int*) malloc(sizeof(int)*numprocs);
+	h->recvDispls = (int*) malloc(sizeof(int)*numprocs);
+	h->sendRanks = (int*) malloc(sizeof(int)*numprocs);
+	h->sendCounts = (int*) malloc(sizeof(int)*numprocs);
+	h->sendDispls = (int*) malloc(sizeof(int)*numprocs);
+	h->recvNeighbors = h->sendNeighbors = 0;
+	for(p=0;p<numprocs;++p){
+		if(allRecvCounts[p] > 0){
+			h->recvRanks[h->recvNeighbors] = p;
+			h->recvCounts[h->recvNeighbors] = allRecvCounts[p];
+			h->recvDispls[h->recvNeighbors] = allRecvDispls[p];
+			++h->recvNeighbors;
+		}
+		if(allSendCounts[p] > 0){
+			h->sendRanks[h->sendNeighbors] = p;
+			h->sendCounts[h->sendNeighbors] = allSendCounts[p];
+			h->sendDispls[h->sendNeighbors] = allSendDispls[p];
+			++h->sendNeighbors;
+		}
+	}
+	h->requests = (MPI_Request*) malloc(sizeof(MPI_Request)*(h->recvNeighbors+h->sendNeighbors+1));
+	free(allRecvCounts);
+	free(allSendCounts);
+	free(allRecvDispls);
+	free(allSendDispls);
+
+	/*
+	 * split of the local matrix, with the local numbering of the columns
+	 */
+	csrInit(&h->diag, local->rows, local->rows, diagNnz);
+	csrInit(&h->offd, local->rows, local->rows+h->haloSize, offdNnz);
+	diagNnz = offdNnz = 0;
+	for(i=0;i<local->rows;++i){
+		for(k=local->rowPtr[i];k<local->rowPtr[i+1];++k){
+			col = local->col[k];
+			if(col >= myFirst && col < myLast){
+				h->diag.col[diagNnz] = col-myFirst;
+				h->diag.val[diagNnz++] = local->val[k];
+			}else{
+				h->offd.col[offdNnz] = local->rows+haloPosition(h, col);
+				h->offd.val[offdNnz++] = local->val[k];
+			}
+		}
+		h->diag.rowPtr[i+1] = diagNnz;
+		h->offd.rowPtr[i+1] = offdNnz;
+	}
+}
+
+void spmv_halo_free(spmv_halo* h){
+	csr_free(&h->diag);
+	csr_free(&h->offd);
+	free(h->haloCols);
+	free(h->recvRanks);
+	free(h->recvCounts);
+	free(h->recvDispls);
+	free(h->sendRanks);
+	free(h->sendCounts);
+	free(h->sendDispls);
+	free(h->sendIndex);
+	free(h->sendBuffer);
+	free(h->requests);
+}
+
+void spmv_halo_start(spmv_halo* h, double* x){
+	int i;
+	for(i=0;i<h->recvNeighbors;++i){
+		MPI_Irecv(x+h->localRows+h->recvDispls[i], h->recvCounts[i], MPI_DOUBLE, h->recvRanks[i], 41, h->comm,
+			&h->requests[i]);
+	}
+	for(i=0;i<h->sendSize;++i){
+		h->sendBuffer[i] = x[h->sendIndex[i]];
+	}
+	for(i=0;i<h->sendNeighbors;++i){
+		MPI_Isend(h->sendBuffer+h->sendDispls[i], h->sendCounts[i], MPI_DOUBLE, h->sendRanks[i], 41, h->comm,
+			&h->requests[h->recvNeighbors+i]);
+	}
+}
+
+void spmv_halo_finish(spmv_halo* h){
+	MPI_Waitall(h->recvNeighbors+h->sendNeighbors, h->requests, MPI_STATUSES_IGNORE);
+}
@@ -0,0 +1,49 @@
+#ifndef SPMV_HALO_H
+#define SPMV_HALO_H
+#include <mpi.h>
+#include "spmv_matrix.h"
+
+/*
+ * Halo exchange of the distributed sparse matrix-vector product:
+ * the rows of A and the values of x are split among the processes in blocks (first[p]..first[p+1]-1),
+ * and a process only needs the values of x of the columns of its rows owned by other processes.
+ * The plan is computed once: the needed columns are sorted by owner, each owner is told which of
+ * its values to send (MPI_Alltoall/MPI_Alltoallv), and the local matrix is split in
+ * + diag: the columns of the own block, numbered 0..localRows-1
+ * + offd: the other columns, numbered localRows.. in the order of the received values
+ * so x holds the own block followed by the received values (the halo).
+ * Each product only exchanges these values with the neighbors (MPI_Isend/MPI_Irecv),
+ * while the diag part is multiplied.
+ */
+
+typedef struct{
+	MPI_Comm comm;
+	int localRows;		/* rows and values of x owned by the process */
+	int haloSize;		/* received values of x */
+	int* haloCols;		/* haloSize, global columns of the received values */
+	csr_matrix diag, offd;
+	/* neighbors */
+	int recvNeighbors, sendNeighbors;
+	int *recvRanks, *recvCounts, *recvDispls;
+	int *sendRanks, *sendCounts, *sendDispls;
+	int sendSize;
+	int* sendIndex;		/* sendSize, local index of the sent values */
+	double* sendBuffer;
+	MPI_Request* requests;
+} spmv_halo;
+
+/*
+ * plan of the rows first[myid]..first[myid+1]-1 of A, stored in local as a CSR matrix with the
+ * global columns; first has numprocs+1 values
+ */
+void spmv_halo_create(spmv_halo* h, MPI_Comm comm, const csr_matrix* local, const int* first);
+void spmv_halo_free(spmv_halo* h);
+/*
+ * starts the exchange: x has localRows+haloSize values, the own block is sent
+ * and the halo is received after it
+ */
+void spmv_halo_start(spmv_halo* h, double* x);
+/* waits for the end of the exchange */
+void spmv_halo_finish(spmv_halo* h);
+
+#endif
@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "spmv_matrix.h"
+
+/* a nonzero of the matrix while it is read */
+typedef struct{
+	int row, col;
+	double val;
+} coo_entry;
+
+/* a row and its length, for the sort of SELL-C-sigma */
+typedef struct{
+	int row;
+	long length;
+} row_length;
+
+static void* allocate(size_t size){
+	void* p = malloc(size > 0 ? size : 1);
+	if(p == NULL){
+		printf("cannot allocate %lu bytes\n", (unsigned long) size);
+		exit(1);
+	}
+	return p;
+}
+
+static int compareEntries(const void* a, const void* b){
+	const coo_entry* e = (const coo_entry*) a;
+	const coo_entry* f = (const coo_entry*) b;
+	if(e->row != f->row) return e->row < f->row ? -1 : 1;
+	if(e->col != f->col) return e->col < f->col ? -1 : 1;
+	return 0;
+}
+
+/* longest rows first, then in the order of the matrix */
+static int compareLengths(const void* a, const void* b){
+	const row_length* r = (const row_length*) a;
+	const row_length* s = (const row_length*) b;
+	if(r->length != s->length) return r->length > s->length ? -1 : 1;
+	return r->row - s->row;
+}
+
+/* lower case copy of a word of the header */
+static void lowerWord(char* word){
+	for(;*word;++word) *word = tolower((unsigned char) *word);
+}
+
+/*
+ * CSR matrix of the sorted entries, the duplicated entries are summed
+ */
+static void csrFromEntries(csr_matrix* A, int rows, int cols, coo_entry* entries, long count){
+	long k, nnz = 0;
+	qsort(entries, count, sizeof(coo_entry), compareEntries);
+	A->rows = rows;
+	A->cols = cols;
+	A->rowPtr = (long*) allocate(sizeof(long)*(rows+1));
+	A->col = (int*) allocate(sizeof(int)*count);
+	A->val = (double*) allocate(sizeof(double)*count);
+	memset(A->rowPtr, 0, sizeof(long)*(rows+1));
+	for(k=0;k<count;++k){
+		if(nnz > 0 && k > 0 && entries[k].row == entries[k-1].row && entries[k].col == entries[k-1].col){
+			A->val[nnz-1] += entries[k].val;
+			continue;
+		}
+		A->col[nnz] = entries[k].col;
+		A->val[nnz] = entries[k].val;
+		++A->rowPtr[entries[k].row+1];
+		++nnz;
+	}
+	for(k=0;k<rows;++k){
+		A->rowPtr[k+1] += A->rowPtr[k];
+	}
+	A->nnz = nnz;
+}
+
+int csr_read_matrix_market(const char* name, csr_matrix* A){
+	char line[1024], object[64], format[64], field[64], symmetry[64];
+	int rows, cols, row, col;
+	long entries, count = 0, k;
+	double val;
+	int isPattern, isSymmetric, isSkew;
+	coo_entry* coo;
+	FILE* input = fopen(name, "r");
+	if(input == NULL){
+		printf("Error reading %s\n", name);
+		return 0;
+	}
+	if(fgets(line, sizeof(line), input) == NULL
+		|| sscanf(line, "%%%%MatrixMarket %63s %63s %63s %63s", object, format, field, symmetry) != 4){
+		printf("%s is not a MatrixMarket file\n", name);
+		fclose(input);
+		return 0;
+	}
+	lowerWord(object);
+	lowerWord(format);
+	lowerWord(field);
+	lowerWord(symmetry);
+	if(strcmp(object, "matrix") != 0 || strcmp(format, "coordinate") != 0 || strcmp(field, "complex") == 0){
+		printf("%s: only the real coordinate matrices are supported\n", name);
+		fclose(input);
+		return 0;
+	}
+	isPattern = strcmp(field, "pattern") == 0;
+	isSymmetric = strcmp(symmetry, "symmetric") == 0;
+	isSkew = strcmp(symmetry, "skew-symmetric") == 0;
+	/*
+	 * comments, then the size line
+	 */
+	do{
+		if(fgets(line, sizeof(line), input) == NULL){
+			printf("%s has no size line\n", name);
+			fclose(input);
+			return 0;
+		}
+	}while(line[0] == '%');
+	if(sscanf(line, "%d %d %ld", &rows, &cols, &entries) != 3 || rows < 1 || cols < 1 || entries < 0){
+		printf("%s: wrong size line\n", name);
+		fclose(input);
+		return 0;
+	}
+	/*
+	 * the symmetric matrices store one triangle, the other one is added
+	 */
+	coo = (coo_entry*) allocate(sizeof(coo_entry)*entries*(isSymmetric || isSkew ? 2 : 1));
+	for(k=0;k<entries;++k){
+		val = 1.0;
+		if(fscanf(input, "%d %d", &row, &col) != 2 || (!isPattern && fscanf(input, "%lf", &val) != 1)
+			|| row < 1 || row > rows || col < 1 || col > cols){
+			printf("%s: wrong entry %ld\n", name, k+1);
+			free(coo);
+			fclose(input);
+			return 0;
+		}
+		coo[count].row = row-1;
+		coo[count].col = col-1;
+		coo[count].val = val;
+		++count;
+		if((isSymmetric || isSkew) && row != col){
+			coo[count].row = col-1;
+			coo[count].col = row-1;
+			coo[count].val = isSkew ? -val : val;
+			++count;
+		}
+	}
+	fclose(input);
+	csrFromEntries(A, rows, cols, coo, count);
+	free(coo);
+	return 1;
+}
+
+void csr_laplacian(csr_matrix* A, int k){
+	int i, j, n = k*k;
+	long count = 0;
+	coo_entry* coo = (coo_entry*) allocate(sizeof(coo_entry)*5*(long)n);
+	for(i=0;i<k;++i){
+		for(j=0;j<k;++j){
+			int row = i*k+j;
+			coo[count].row = row; coo[count].col = row; coo[count].val = 4.0; ++count;
+			if(i > 0){ coo[count].row = row; coo[count].col = row-k; coo[count].val = -1.0; ++count; }
+			if(i < k-1){ coo[count].row = row; coo[count].col = row+k; coo[count].val = -1.0; ++count; }
+			if(j > 0){ coo[count].row = row; coo[count].col = row-1; coo[count].val = -1.0; ++count; }
+			if(j < k-1){ coo[count].row = row; coo[count].col = row+1; coo[count].val = -1.0; ++count; }
+		}
+	}
+	csrFromEntries(A, n, n, coo, count);
+	free(coo);
+}
+
+void csr_free(csr_matrix* A){
+	free(A->rowPtr);
+	free(A->col);
+	free(A->val);
+}
+
+void csr_multiply_rows(const csr_matrix* A, const double* x, double* y, int first, int last){
+	int i;
+	long k;
+	for(i=first;i<last;++i){
+		double sum = 0.0;
+		for(k=A->rowPtr[i];k<A->rowPtr[i+1];++k){
+			sum += A->val[k]*x[A->col[k]];
+		}
+		y[i] = sum;
+	}
+}
+
+void csr_multiply_add_rows(const csr_matrix* A, const double* x, double* y, int first, int last){
+	int i;
+	long k;
+	for(i=first;i<last;++i){
+		double sum = y[i];
+		for(k=A->rowPtr[i];k<A->rowPtr[i+1];++k){
+			sum += A->val[k]*x[A->col[k]];
+		}
+		y[i] = sum;
+	}
+}
+
+/*
+ * first[p] is the first index whose prefix reaches total*p/parts,
+ * prefix has count+1 increasing values
+ */
+static void partitionPrefix(const long* prefix, int count, int parts, int* first){
+	int p, low, high, middle;
+	long target;
+	first[0] = 0;
+	for(p=1;p<parts;++p){
+		target = (long) ((double) prefix[count]*p/parts);
+		low = first[p-1];
+		high = count;
+		while(low < high){
+			middle = (low+high)/2;
+			if(prefix[middle] < target) low = middle+1;
+			else high = middle;
+		}
+		first[p] = low;
+	}
+	first[parts] = count;
+}
+
+void csr_partition_nnz(const csr_matrix* A, int parts, int* first){
+	partitionPrefix(A->rowPtr, A->rows, parts, first);
+}
+
+void csr_partition_rows(const csr_matrix* A, int parts, int* first){
+	int p;
+	for(p=0;p<=parts;++p){
+		first[p] = (int) ((long) A->rows*p/parts);
+	}
+}
+
+void sell_from_csr(sell_matrix* S, const csr_matrix* A, int C, int sigma){
+	int i, c, r, j, w, row;
+	long length, index;
+	row_length* lengths = (row_length*) allocate(sizeof(row_length)*A->rows);
+
+	if(C > SELL_MAX_C) C = SELL_MAX_C;
+	if(sigma < 1) sigma = 1;
+	S->rows = A->rows;
+	S->cols = A->cols;
+	S->C = C;
+	S->sigma = sigma;
+	S->nnz = A->nnz;
+	S->chunks = (A->rows+C-1)/C;
+	/*
+	 * sort of the rows by length inside each window of sigma rows
+	 */
+	for(i=0;i<A->rows;++i){
+		lengths[i].row = i;
+		lengths[i].length = A->rowPtr[i+1]-A->rowPtr[i];
+	}
+	for(w=0;w<A->rows;w+=sigma){
+		qsort(lengths+w, (A->rows-w < sigma ? A->rows-w : sigma), sizeof(row_length), compareLengths);
+	}
+	S->perm = (int*) allocate(sizeof(int)*S->chunks*C);
+	S->chunkLen = (int*) allocate(sizeof(int)*S->chunks);
+	S->chunkPtr = (long*) allocate(sizeof(long)*(S->chunks+1));
+	S->chunkPtr[0] = 0;
+	for(c=0;c<S->chunks;++c){
+		S->chunkLen[c] = 0;
+		for(r=0;r<C;++r){
+			i = c*C+r;
+			S->perm[i] = i < A->rows ? lengths[i].row : -1;
+			if(i < A->rows && lengths[i].length > S->chunkLen[c]) S->chunkLen[c] = (int) lengths[i].length;
+		}
+		S->chunkPtr[c+1] = S->chunkPtr[c]+(long)S->chunkLen[c]*C;
+	}
+	S->paddedNnz = S->chunkPtr[S->chunks];
+	S->col = (int*) allocate(sizeof(int)*S->paddedNnz);
+	S->val = (double*) allocate(sizeof(double)*S->paddedNnz);
+	/*
+	 * column by column inside a chunk, the padding repeats the last column of the row (already in cache)
+	 */
+	for(c=0;c<S->chunks;++c){
+		for(r=0;r<C;++r){
+			row = S->perm[c*C+r];
+			length = row >= 0 ? A->rowPtr[row+1]-A->rowPtr[row] : 0;
+			for(j=0;j<S->chunkLen[c];++j){
+				index = S->chunkPtr[c]+(long)j*C+r;
+				if(j < length){
+					S->col[index] = A->col[A->rowPtr[row]+j];
+					S->val[index] = A->val[A->rowPtr[row]+j];
+				}else{
+					S->col[index] = length > 0 ? A->col[A->rowPtr[row]+length-1] : 0;
+					S->val[index] = 0.0;
+				}
+			}
+		}
+	}
+	free(lengths);
+}
+
+void sell_free(sell_matrix* S){
+	free(S->chunkPtr);
+	free(S->chunkLen);
+	free(S->col);
+	free(S->val);
+	free(S->perm);
+}
+
+void sell_multiply_chunks(const sell_matrix* S, const double* x, double* y, int first, int last){
+	int c, r, j;
+	int C = S->C;
+	double sum[SELL_MAX_C];
+	for(c=first;c<last;++c){
+		const int* col = S->col+S->chunkPtr[c];
+		const double* val = S->val+S->chunkPtr[c];
+		for(r=0;r<C;++r) sum[r] = 0.0;
+		/*
+		 * the C rows of the chunk together
+		 */
+		for(j=0;j<S->chunkLen[c];++j){
+			#pragma omp simd
+			for(r=0;r<C;++r){
+				sum[r] += val[j*C+r]*x[col[j*C+r]];
+			}
+		}
+		for(r=0;r<C;++r){
+			int row = S->perm[c*C+r];
+			if(row >= 0) y[row] = sum[r];
+		}
+	}
+}
+
+void sell_partition_nnz(const sell_matrix* S, int parts, int* first){
+	partitionPrefix(S->chunkPtr, S->chunks, parts, first);
+}
@@ -0,0 +1,70 @@
+#ifndef SPMV_MATRIX_H
+#define SPMV_MATRIX_H
+
+/*
+ * Sparse matrices for the sparse matrix-vector products (SpMV) y = A x, in double precision:
+ * + CSR (compressed sparse rows): the nonzeros row after row, with their column,
+ *   rowPtr[i]..rowPtr[i+1]-1 are the nonzeros of row i.
+ * + SELL-C-sigma: the rows are sorted by length inside windows of sigma rows, then cut in chunks
+ *   of C rows padded to the longest row of the chunk, and each chunk is stored column by column:
+ *   the C rows of a chunk are multiplied together (SIMD), with few padding zeros thanks to the sort.
+ * The partitions give each thread a block of rows (CSR) or chunks (SELL) with the same
+ * number of nonzeros, not the same number of rows (the OpenMP products are in spmv_omp.h).
+ * This file does not use the OpenMP runtime, only the simd directive (-fopenmp-simd).
+ */
+
+/* CSR matrix */
+typedef struct{
+	int rows, cols;
+	long nnz;
+	long* rowPtr;		/* rows+1 */
+	int* col;		/* nnz */
+	double* val;		/* nnz */
+} csr_matrix;
+
+/* largest chunk height */
+#define SELL_MAX_C 64
+
+/* SELL-C-sigma matrix */
+typedef struct{
+	int rows, cols;
+	int C, sigma;
+	int chunks;
+	long nnz;		/* nonzeros of the matrix */
+	long paddedNnz;		/* stored values, with the padding */
+	long* chunkPtr;		/* chunks+1, first value of each chunk */
+	int* chunkLen;		/* chunks, length of the longest row of each chunk */
+	int* col;		/* paddedNnz */
+	double* val;		/* paddedNnz, 0 for the padding */
+	int* perm;		/* chunks*C, row of the matrix stored at each position, -1 for the padding rows */
+} sell_matrix;
+
+/*
+ * reads a MatrixMarket file (coordinate, real/integer/pattern, general/symmetric),
+ * the duplicated entries are summed; returns 0 with a message on error
+ */
+int csr_read_matrix_market(const char* name, csr_matrix* A);
+/* the matrix of the 5 point Laplacian on a k x k grid (k^2 rows) */
+void csr_laplacian(csr_matrix* A, int k);
+void csr_free(csr_matrix* A);
+/* y[first..last-1] = A[first..last-1] x */
+void csr_multiply_rows(const csr_matrix* A, const double* x, double* y, int first, int last);
+/* y[first..last-1] += A[first..last-1] x */
+void csr_multiply_add_rows(const csr_matrix* A, const double* x, double* y, int first, int last);
+/*
+ * split of the rows in parts blocks with about the same number of nonzeros:
+ * block p is first[p]..first[p+1]-1, first has parts+1 values
+ */
+void csr_partition_nnz(const csr_matrix* A, int parts, int* first);
+/* the same with the same number of rows */
+void csr_partition_rows(const csr_matrix* A, int parts, int* first);
+
+/* SELL-C-sigma matrix of a CSR matrix */
+void sell_from_csr(sell_matrix* S, const csr_matrix* A, int C, int sigma);
+void sell_free(sell_matrix* S);
+/* y = S x for the chunks first..last-1, y in the order of the rows of the matrix */
+void sell_multiply_chunks(const sell_matrix* S, const double* x, double* y, int first, int last);
+/* split of the chunks in parts blocks with about the same number of stored values */
+void sell_partition_nnz(const sell_matrix* S, int parts, int* first);
+
+#endif
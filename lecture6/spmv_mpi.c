@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <omp.h>
+#include <mpi.h>
+#include "spmv_matrix.h"
+#include "spmv_omp.h"
+#include "spmv_halo.h"
+
+/*
+ * Distributed sparse matrix-vector product (MPI + OpenMP): process 0 reads a MatrixMarket matrix
+ * (or makes the 5 point Laplacian), and the rows are split among the processes with the same number
+ * of nonzeros. The x of a product is split like the rows. The products are compared:
+ * + halo: the plan of spmv_halo.h, only the needed values of x are exchanged with the neighbors,
+ *   while the columns of the own block are multiplied
+ * + allgatherv: the whole x is gathered on every process (MPI_Allgatherv) before the CSR product
+ * + dense: the same with the dense rows of the matrix (at most SPMV_DENSE_LIMIT columns), as lecture4/mvm_distributed.c
+ * the local products use the OpenMP threads, with the rows split by nonzeros.
+ */
+
+/* the products */
+typedef enum{
+	METHOD_HALO = 0,
+	METHOD_ALLGATHERV,
+	METHOD_DENSE,
+	METHODS
+} spmv_method;
+
+static const char* methodNames[METHODS] = {"halo", "allgatherv", "dense"};
+
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv, int myid, char** inputName, int* gridSize, int* threads, int* iterations);
+/* rows first[myid]..first[myid+1]-1 of the matrix of process 0, with the global columns */
+void distributeRows(const csr_matrix* A, const int* first, csr_matrix* local);
+
+/*
+ * to compile:
+ * mpicc -O2 -fopenmp -o spmv_mpi spmv_mpi.c spmv_matrix.c spmv_omp.c spmv_halo.c -lm
+ * to run, the Laplacian of a 1000 x 1000 grid on 4 processes of 2 threads:
+ * mpirun -np 4 ./spmv_mpi -g 1000 -t 2
+ */
+int main(int argc, char* argv[]){
+
+	int provided;
+	/*
+	 * the OpenMP threads do not call MPI, only the master thread does (MPI_THREAD_FUNNELED)
+	 */
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+	int myid, numprocs, p, i, k, method;
+	char* inputName = NULL;
+	int gridSize = 512;
+	int threads = 1;
+	int iterations = 100;
+	int size[2];		/* rows and columns */
+	int myRows, myFirst;
+	int *first, *counts, *diagFirst, *offdFirst, *localFirst;
+	long globalNnz = 0, j;
+	csr_matrix A, local;
+	spmv_halo h;
+	double *x, *xFull, *y, *yFull = NULL, *reference = NULL, *dense = NULL;
+	double time, maxTime, received, maxReceived, error;
+	int isDense;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+	parseArgs(argc, argv, myid, &inputName, &gridSize, &threads, &iterations);
+	if(provided < MPI_THREAD_FUNNELED){
+		if(myid == 0) printf("The MPI library does not support MPI_THREAD_FUNNELED\n");
+		MPI_Finalize();
+		return 1;
+	}
+
+	/*
+	 * process 0 reads the matrix and splits the rows by nonzeros
+	 */
+	first = (int*) malloc(sizeof(int)*(numprocs+1));
+	size[0] = size[1] = 0;
+	if(myid == 0){
+		if(inputName == NULL || csr_read_matrix_market(inputName, &A)){
+			if(inputName == NULL) csr_laplacian(&A, gridSize);
+			size[0] = A.rows;
+			size[1] = A.cols;
+			globalNnz = A.nnz;
+			csr_partition_nnz(&A, numprocs, first);
+		}
+	}
+	MPI_Bcast(size, 2, MPI_INT, 0, MPI_COMM_WORLD);
+	if(size[0] == 0){
+		MPI_Finalize();
+		return 1;
+	}
+	if(size[0] != size[1]){
+		if(myid == 0) printf("the matrix must be square, x is split like the rows\n");
+		MPI_Finalize();
+		return 1;
+	}
+	MPI_Bcast(first, numprocs+1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Bcast(&globalNnz, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+	myFirst = first[myid];
+	myRows = first[myid+1]-first[myid];
+	distributeRows(&A, first, &local);
+	spmv_halo_create(&h, MPI_COMM_WORLD, &local, first);
+
+	/*
+	 * x: the own block, then the halo; the whole x for the allgatherv products
+	 */
+	x = (double*) malloc(sizeof(double)*(myRows+h.haloSize+1));
+	xFull = (double*) malloc(sizeof(double)*size[1]);
+	y = (double*) malloc(sizeof(double)*(myRows+1));
+	for(i=0;i<myRows;++i){
+		x[i] = 1.0/(1+(myFirst+i)%5);
+	}
+	counts = (int*) malloc(sizeof(int)*numprocs);
+	for(p=0;p<numprocs;++p){
+		counts[p] = first[p+1]-first[p];
+	}
+	diagFirst = (int*) malloc(sizeof(int)*(threads+1));
+	offdFirst = (int*) malloc(sizeof(int)*(threads+1));
+	localFirst = (int*) malloc(sizeof(int)*(threads+1));
+	csr_partition_nnz(&h.diag, threads, diagFirst);
+	csr_partition_nnz(&h.offd, threads, offdFirst);
+	csr_partition_nnz(&local, threads, localFirst);
+	isDense = size[1] <= SPMV_DENSE_LIMIT;
+	if(isDense){
+		dense = (double*) calloc((size_t) myRows*size[1]+1, sizeof(double));
+		for(i=0;i<myRows;++i){
+			for(j=local.rowPtr[i];j<local.rowPtr[i+1];++j){
+				dense[(size_t)i*size[1]+local.col[j]] = local.val[j];
+			}
+		}
+	}
+	if(myid == 0){
+		yFull = (double*) malloc(sizeof(double)*size[0]);
+		reference = (double*) malloc(sizeof(double)*size[0]);
+		for(i=0;i<size[1];++i){
+			xFull[i] = 1.0/(1+i%5);
+		}
+		csr_multiply_rows(&A, xFull, reference, 0, A.rows);
+	}
+
+	received = h.haloSize;
+	MPI_Reduce(&received, &maxReceived, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	if(myid == 0){
+		printf("matrix %d x %d, %ld nonzeros, %d processes of %d threads, halo of at most %.0f values\n",
+			size[0], size[1], globalNnz, numprocs, threads, maxReceived);
+		printf("method\t\ttime/product (us)\tGFLOP/s\t\treceived values/process\terror\n");
+	}
+	for(method=0;method<METHODS;++method){
+		if(method == METHOD_DENSE && !isDense) continue;
+		MPI_Barrier(MPI_COMM_WORLD);
+		time = MPI_Wtime();
+		for(k=0;k<iterations;++k){
+			if(method == METHOD_HALO){
+				spmv_halo_start(&h, x);
+				csr_multiply_omp(&h.diag, x, y, threads, diagFirst);
+				spmv_halo_finish(&h);
+				csr_multiply_add_omp(&h.offd, x, y, threads, offdFirst);
+			}else{
+				MPI_Allgatherv(x, myRows, MPI_DOUBLE, xFull, counts, first, MPI_DOUBLE, MPI_COMM_WORLD);
+				if(method == METHOD_ALLGATHERV){
+					csr_multiply_omp(&local, xFull, y, threads, localFirst);
+				}else{
+					dense_multiply_omp(dense, xFull, y, myRows, size[1], threads);
+				}
+			}
+		}
+		time = MPI_Wtime()-time;
+		MPI_Reduce(&time, &maxTime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+		received = method == METHOD_HALO ? h.haloSize : size[1]-myRows;
+		MPI_Reduce(&received, &maxReceived, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+		/*
+		 * check on process 0
+		 */
+		MPI_Gatherv(y, myRows, MPI_DOUBLE, yFull, counts, first, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+		if(myid == 0){
+			error = 0.0;
+			for(i=0;i<size[0];++i){
+				double e = fabs(yFull[i]-reference[i])/(fabs(reference[i]) > 1.0 ? fabs(reference[i]) : 1.0);
+				if(e > error) error = e;
+			}
+			printf("%-12s\t%f\t\t%f\t%.0f\t\t\t%g\n", methodNames[method], 1e6*maxTime/iterations,
+				2.0*globalNnz*iterations/maxTime/1e9, maxReceived, error);
+		}
+	}
+
+	spmv_halo_free(&h);
+	csr_free(&local);
+	if(myid == 0) csr_free(&A);
+	free(first);
+	free(counts);
+	free(diagFirst);
+	free(offdFirst);
+	free(localFirst);
+	free(x);
+	free(xFull);
+	free(y);
+	free(yFull);
+	free(reference);
+	free(dense);
+	MPI_Finalize();
+	return 0;
+}
+
+void distributeRows(const csr_matrix* A, const int* first, csr_matrix* local){
+	int myid, numprocs, p, i;
+	int myRows;
+	int *lengths = NULL, *myLengths, *nnzCounts = NULL, *nnzDispls = NULL, myNnz;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+	MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+	myRows = first[myid+1]-first[myid];
+	/*
+	 * the lengths of the rows, then their columns and values
+	 */
+	if(myid == 0){
+		int* rowCounts = (int*) malloc(sizeof(int)*numprocs);
+		lengths = (int*) malloc(sizeof(int)*A->rows);
+		nnzCounts = (int*) malloc(sizeof(int)*numprocs);
+		nnzDispls = (int*) malloc(sizeof(int)*numprocs);
+		for(i=0;i<A->rows;++i){
+			lengths[i] = (int) (A->rowPtr[i+1]-A->rowPtr[i]);
+		}
+		for(p=0;p<numprocs;++p){
+			rowCounts[p] = first[p+1]-first[p];
+			nnzCounts[p] = (int) (A->rowPtr[first[p+1]]-A->rowPtr[first[p]]);
+			nnzDispls[p] = (int) A->rowPtr[first[p]];
+		}
+		myLengths = (int*) malloc(sizeof(int)*(myRows+1));
+		MPI_Scatterv(lengths, rowCounts, (int*) first, MPI_INT, myLengths, myRows, MPI_INT, 0, MPI_COMM_WORLD);
+		free(rowCounts);
+	}else{
+		myLengths = (int*) malloc(sizeof(int)*(myRows+1));
+		MPI_Scatterv(NULL, NULL, NULL, MPI_INT, myLengths, myRows, MPI_INT, 0, MPI_COMM_WORLD);
+	}
+	local->rows = myRows;
+	local->cols = A != NULL && myid == 0 ? A->cols : 0;
+	local->rowPtr = (long*) malloc(sizeof(long)*(myRows+1));
+	local->rowPtr[0] = 0;
+	for(i=0;i<myRows;++i){
+		local->rowPtr[i+1] = local->rowPtr[i]+myLengths[i];
+	}
+	local->nnz = local->rowPtr[myRows];
+	myNnz = (int) local->nnz;
+	local->col = (int*) malloc(sizeof(int)*(myNnz > 0 ? myNnz : 1));
+	local->val = (double*) malloc(sizeof(double)*(myNnz > 0 ? myNnz : 1));
+	MPI_Scatterv(myid == 0 ? A->col : NULL, nnzCounts, nnzDispls, MPI_INT, local->col, myNnz, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Scatterv(myid == 0 ? A->val : NULL, nnzCounts, nnzDispls, MPI_DOUBLE, local->val, myNnz, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	MPI_Bcast(&local->cols, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	free(myLengths);
+	free(lengths);
+	free(nnzCounts);
+	free(nnzDispls);
+}
+
+void parseArgs(int argc, char** argv, int myid, char** inputName, int* gridSize, int* threads, int* iterations){
+	int c;
+	while((c=getopt(argc, argv, "f:g:t:i:")) != -1){
+		switch(c){
+			case 'f':
+				*inputName = optarg;
+				break;
+			case 'g':
+				*gridSize = atoi(optarg);
+				break;
+			case 't':
+				*threads = atoi(optarg);
+				break;
+			case 'i':
+				*iterations = atoi(optarg);
+				break;
+			default:
+				if(myid == 0) printf("usage: %s [-f matrix.mtx | -g gridSize] [-t threads] [-i iterations]\n", argv[0]);
+				MPI_Finalize();
+				exit(1);
+		}
+	}
+	if(*gridSize < 1 || *threads < 1 || *iterations < 1){
+		if(myid == 0) printf("the arguments must be positive\n");
+		MPI_Finalize();
+		exit(1);
+	}
+}
@@ -0,0 +1,43 @@
+#include <stddef.h>
+#include "spmv_omp.h"
+
+/*
+ * the blocks are the iterations of the loop, so they are all computed even if the runtime
+ * gives fewer than parts threads (OMP_DYNAMIC, OMP_THREAD_LIMIT, nested regions)
+ */
+void csr_multiply_omp(const csr_matrix* A, const double* x, double* y, int parts, const int* first){
+	int t;
+	#pragma omp parallel for num_threads(parts) schedule(static,1)
+	for(t=0;t<parts;++t){
+		csr_multiply_rows(A, x, y, first[t], first[t+1]);
+	}
+}
+
+void csr_multiply_add_omp(const csr_matrix* A, const double* x, double* y, int parts, const int* first){
+	int t;
+	#pragma omp parallel for num_threads(parts) schedule(static,1)
+	for(t=0;t<parts;++t){
+		csr_multiply_add_rows(A, x, y, first[t], first[t+1]);
+	}
+}
+
+void sell_multiply_omp(const sell_matrix* S, const double* x, double* y, int parts, const int* first){
+	int t;
+	#pragma omp parallel for num_threads(parts) schedule(static,1)
+	for(t=0;t<parts;++t){
+		sell_multiply_chunks(S, x, y, first[t], first[t+1]);
+	}
+}
+
+void dense_multiply_omp(const double* A, const double* x, double* y, int rows, int cols, int threads){
+	int i, j;
+	#pragma omp parallel for num_threads(threads) schedule(static) private(j)
+	for(i=0;i<rows;++i){
+		const double* row = A+(size_t)i*cols;
+		double sum = 0.0;
+		for(j=0;j<cols;++j){
+			sum += row[j]*x[j];
+		}
+		y[i] = sum;
+	}
+}
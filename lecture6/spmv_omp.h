@@ -0,0 +1,18 @@
+#ifndef SPMV_OMP_H
+#define SPMV_OMP_H
+#include "spmv_matrix.h"
+
+/* largest number of rows (spmv.c) or columns (spmv_mpi.c) of a matrix also multiplied as a dense matrix */
+#define SPMV_DENSE_LIMIT 8192
+
+/*
+ * threaded products with OpenMP: parts threads, block t of the partition is computed by thread t
+ * when the runtime gives the parts threads
+ */
+void csr_multiply_omp(const csr_matrix* A, const double* x, double* y, int parts, const int* first);
+void csr_multiply_add_omp(const csr_matrix* A, const double* x, double* y, int parts, const int* first);
+void sell_multiply_omp(const sell_matrix* S, const double* x, double* y, int parts, const int* first);
+/* y = A x for the dense rows x cols matrix, the rows split evenly among the threads */
+void dense_multiply_omp(const double* A, const double* x, double* y, int rows, int cols, int threads);
+
+#endif
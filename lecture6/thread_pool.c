@@ -0,0 +1,114 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <unistd.h>
+#include "thread_pool.h"
+
+/* argument of a thread of the pool */
+typedef struct{
+	thread_pool* pool;
+	int tid, pin;
+} pool_thread;
+
+void pool_pin(int tid){
+	cpu_set_t set;
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	CPU_ZERO(&set);
+	CPU_SET(tid % (processors > 0 ? processors : 1), &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void* poolThread(void* argument){
+	pool_thread* self = (pool_thread*) argument;
+	thread_pool* pool = self->pool;
+	int tid = self->tid, spins;
+	long seen = 0;
+	if(self->pin) pool_pin(tid);
+	free(self);
+	for(;;){
+		if(pool->dispatch == POOL_BARRIER){
+			pthread_barrier_wait(&pool->start);
+			if(pool->stop) break;
+			pool->task(pool->argument, tid, pool->threads);
+			pthread_barrier_wait(&pool->done);
+		}else{
+			/*
+			 * the task and the argument are written before the counter (release)
+			 */
+			spins = 0;
+			while(atomic_load_explicit(&pool->posted, memory_order_acquire) == seen){
+				if(++spins > POOL_SPINS) sched_yield();
+			}
+			++seen;
+			if(pool->stop) break;
+			pool->task(pool->argument, tid, pool->threads);
+			atomic_fetch_sub_explicit(&pool->running, 1, memory_order_release);
+		}
+	}
+	return NULL;
+}
+
+void pool_create(thread_pool* pool, int threads, pool_dispatch dispatch, int pin){
+	int t;
+	pool->threads = threads;
+	pool->dispatch = dispatch;
+	pool->stop = 0;
+	pool->task = NULL;
+	pool->argument = NULL;
+	atomic_init(&pool->posted, 0);
+	atomic_init(&pool->running, 0);
+	pthread_barrier_init(&pool->start, NULL, threads);
+	pthread_barrier_init(&pool->done, NULL, threads);
+	pool->handles = (pthread_t*) malloc(sizeof(pthread_t)*threads);
+	if(pin) pool_pin(0);
+	for(t=1;t<threads;++t){
+		pool_thread* self = (pool_thread*) malloc(sizeof(pool_thread));
+		self->pool = pool;
+		self->tid = t;
+		self->pin = pin;
+		if(pthread_create(&pool->handles[t], NULL, poolThread, self) != 0){
+			printf("cannot create the thread %d of the pool\n", t);
+			exit(1);
+		}
+	}
+}
+
+void pool_run(thread_pool* pool, pool_task task, void* argument){
+	int spins = 0;
+	pool->task = task;
+	pool->argument = argument;
+	if(pool->threads == 1){
+		task(argument, 0, 1);
+	}else if(pool->dispatch == POOL_BARRIER){
+		pthread_barrier_wait(&pool->start);
+		task(argument, 0, pool->threads);
+		pthread_barrier_wait(&pool->done);
+	}else{
+		atomic_store_explicit(&pool->running, pool->threads-1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&pool->posted, 1, memory_order_release);
+		task(argument, 0, pool->threads);
+		while(atomic_load_explicit(&pool->running, memory_order_acquire) > 0){
+			if(++spins > POOL_SPINS) sched_yield();
+		}
+	}
+}
+
+void pool_destroy(thread_pool* pool){
+	int t;
+	/*
+	 * the stop is posted as a task
+	 */
+	pool->stop = 1;
+	if(pool->dispatch == POOL_BARRIER){
+		if(pool->threads > 1) pthread_barrier_wait(&pool->start);
+	}else{
+		atomic_fetch_add_explicit(&pool->posted, 1, memory_order_release);
+	}
+	for(t=1;t<pool->threads;++t){
+		pthread_join(pool->handles[t], NULL);
+	}
+	pthread_barrier_destroy(&pool->start);
+	pthread_barrier_destroy(&pool->done);
+	free(pool->handles);
+}
@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+ * Pool of threads created once and reused by every call, instead of pthread_create/pthread_join per call
+ * (pthreadsMVM.c): a call posts a task, the threads 1..threads-1 of the pool and the calling thread
+ * (thread 0) run it with their number, and the call returns when all of them are done.
+ * The threads wait for the next task with
+ * + POOL_BARRIER: pthread_barrier_wait, the waiting threads sleep in the kernel
+ * + POOL_SPIN: a counter of the posted tasks, polled by the waiting threads (sched_yield after
+ *   POOL_SPINS polls), no system call on the way, the lowest latency when each thread has its core
+ * with pinning, thread t runs on the processor t modulo the number of processors.
+ * There is no queue of tasks: a call is one task run by all the threads (fork-join), the latency of
+ * a product is the time to post it and wait for the threads, and the next call is only posted after it.
+ * A queue only pays off for independent tasks of uneven cost, as the chunks of work_steal.h.
+ */
+#define POOL_SPINS 1000
+
+typedef enum{
+	POOL_BARRIER = 0,
+	POOL_SPIN
+} pool_dispatch;
+
+/* task of the pool, run by each thread with its number */
+typedef void (*pool_task)(void* argument, int tid, int threads);
+
+typedef struct{
+	int threads;
+	pool_dispatch dispatch;
+	pthread_t* handles;
+	pool_task task;			/* current task */
+	void* argument;
+	int stop;
+	/* POOL_BARRIER */
+	pthread_barrier_t start, done;
+	/* POOL_SPIN */
+	atomic_long posted;		/* number of the task */
+	atomic_int running;		/* threads of the pool still running it */
+} thread_pool;
+
+/* creates threads-1 threads, exits if they cannot be created */
+void pool_create(thread_pool* pool, int threads, pool_dispatch dispatch, int pin);
+/* runs the task on all the threads and waits for it */
+void pool_run(thread_pool* pool, pool_task task, void* argument);
+void pool_destroy(thread_pool* pool);
+/* pins the calling thread on the processor tid modulo the number of processors */
+void pool_pin(int tid);
+
+#endif
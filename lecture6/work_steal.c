@@ -0,0 +1,43 @@
+#include "work_steal.h"
+
+void steal_deque_reset(steal_deque* d, long first, long last){
+	atomic_store_explicit(&d->top, first, memory_order_relaxed);
+	atomic_store_explicit(&d->bottom, last, memory_order_relaxed);
+}
+
+long steal_pop(steal_deque* d){
+	long b = atomic_load_explicit(&d->bottom, memory_order_relaxed)-1;
+	long t, chunk = b;
+	/*
+	 * the bottom is moved before the top is read, so a thief and the owner cannot both take the last chunk
+	 */
+	atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	t = atomic_load_explicit(&d->top, memory_order_relaxed);
+	if(t > b){
+		atomic_store_explicit(&d->bottom, b+1, memory_order_relaxed);
+		return STEAL_EMPTY;
+	}
+	if(t == b){
+		/*
+		 * the last chunk, against the thieves
+		 */
+		if(!atomic_compare_exchange_strong_explicit(&d->top, &t, t+1, memory_order_seq_cst, memory_order_relaxed)){
+			chunk = STEAL_EMPTY;
+		}
+		atomic_store_explicit(&d->bottom, b+1, memory_order_relaxed);
+	}
+	return chunk;
+}
+
+long steal_take(steal_deque* d){
+	long t = atomic_load_explicit(&d->top, memory_order_acquire);
+	long b;
+	atomic_thread_fence(memory_order_seq_cst);
+	b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+	if(t >= b) return STEAL_EMPTY;
+	if(!atomic_compare_exchange_strong_explicit(&d->top, &t, t+1, memory_order_seq_cst, memory_order_relaxed)){
+		return STEAL_ABORT;
+	}
+	return t;
+}
@@ -0,0 +1,27 @@
+#ifndef WORK_STEAL_H
+#define WORK_STEAL_H
+#include <stdatomic.h>
+
+/*
+ * Deque of chunks of work of a thread for work stealing (Chase-Lev, without the pushes):
+ * the chunks first..last-1 are given to the thread at the start, the owner takes them from the bottom
+ * (the last one first) and the other threads steal from the top with a compare-and-swap,
+ * so no lock is taken and the owner only synchronizes with a thief for the last chunk.
+ * The two ends are on separate cache lines, and the deques of the threads too.
+ */
+#define STEAL_EMPTY -1
+#define STEAL_ABORT -2
+
+typedef struct{
+	_Alignas(64) atomic_long top;	/* next chunk stolen */
+	_Alignas(64) atomic_long bottom;	/* one after the next chunk of the owner */
+} steal_deque;
+
+/* the deque holds the chunks first..last-1, not concurrently with the other calls */
+void steal_deque_reset(steal_deque* d, long first, long last);
+/* by the owner: a chunk or STEAL_EMPTY */
+long steal_pop(steal_deque* d);
+/* by the other threads: a chunk, STEAL_EMPTY, or STEAL_ABORT if another thread took it first */
+long steal_take(steal_deque* d);
+
+#endif
@@ -0,0 +1,392 @@
+/*
+  Backward Substitution step
+  in the Gaussian Elimination
+  for solving upper triangular systems of linear equations:
+  Ax = b
+  with OpenMP,
+  using the row-oriented algorthm
+  and column-oriented algorithm.
+  ====
+  The solvers do not use any global variable:
+  the dimension, the thread number, the layout of A, the schedules
+  and the workspace are read from the plan (see back_substitution.h).
+*/
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+#include<omp.h>
+#include "back_substitution.h"
+/**/
+#define MAX_REFINE_ITERATIONS 50
+#define CALIBRATION_RUNS 3
+/* element (i,j) of A, with the layout of the plan */
+#define ELEMENT(plan,A,i,j) ((A)[(long)(i)*(plan)->rowStride + (long)(j)*(plan)->colStride])
+/*
+   set the schedule used by the schedule(runtime) loops of the calling thread,
+   returns the schedule of the caller, restored at the end of the solve
+*/
+static bs_loop_schedule use_schedule(bs_loop_schedule schedule);
+/* openmp row-oriented backward substitution in single precision, A is row-major */
+static void solve_row_float(const bs_plan* plan, const float* A, const float* b, float* x);
+/**/
+bs_plan* bs_plan_create(int systemSize, int threadNumber, bs_layout layout, int flags)
+{
+  bs_plan* plan;
+  /**/
+  if(systemSize <= 0 || threadNumber <= 0) return NULL;
+  plan = (bs_plan*) calloc(1,sizeof(bs_plan));
+  if(plan == NULL) return NULL;
+  plan->systemSize = systemSize;
+  plan->threadNumber = threadNumber;
+  plan->layout = layout;
+  plan->rowStride = (layout == BS_ROW_MAJOR) ? systemSize : 1;
+  plan->colStride = (layout == BS_ROW_MAJOR) ? 1 : systemSize;
+  plan->rowSchedule.kind = omp_sched_static;
+  plan->rowSchedule.chunk = 0;
+  plan->colSchedule = plan->rowSchedule;
+  plan->maxRefineIterations = MAX_REFINE_ITERATIONS;
+  plan->flags = flags;
+  /* workspace */
+  if(flags & BS_PLAN_MIXED_PRECISION)
+  {
+    plan->Af = (float*) malloc(sizeof(float)*systemSize*systemSize);
+    plan->bf = (float*) malloc(sizeof(float)*systemSize);
+    plan->xf = (float*) malloc(sizeof(float)*systemSize);
+    plan->r = (double*) malloc(sizeof(double)*systemSize);
+    if(plan->Af == NULL || plan->bf == NULL || plan->xf == NULL || plan->r == NULL)
+    {
+      bs_plan_destroy(plan);
+      return NULL;
+    }
+    bs_first_touch_vector(plan,plan->r);
+  }
+  return plan;
+}
+/**/
+void bs_plan_destroy(bs_plan* plan)
+{
+  if(plan == NULL) return;
+  free(plan->Af);
+  free(plan->bf);
+  free(plan->xf);
+  free(plan->r);
+  free(plan);
+}
+/**/
+const char* bs_schedule_name(omp_sched_t kind)
+{
+  switch(kind)
+  {
+    case omp_sched_static: return "static";
+    case omp_sched_dynamic: return "dynamic";
+    case omp_sched_guided: return "guided";
+    default: return "auto";
+  }
+}
+/**/
+static bs_loop_schedule use_schedule(bs_loop_schedule schedule)
+{
+  bs_loop_schedule previous;
+  /**/
+  omp_get_schedule(&previous.kind,&previous.chunk);
+  omp_set_schedule(schedule.kind,schedule.chunk);
+  return previous;
+}
+/**/
+int bs_plan_load_schedules(bs_plan* plan, const char* fileName)
+{
+  FILE* cache;
+  char solver[16], kind[16];
+  int size, threads, chunk;
+  int found = 0;
+  bs_loop_schedule schedule;
+  /**/
+  cache = fopen(fileName,"r");
+  if(cache == NULL) return 0;
+  /* line: system_size thread_number row|col kind chunk, the last matching line wins */
+  while(fscanf(cache,"%d %d %15s %15s %d",&size,&threads,solver,kind,&chunk) == 5)
+  {
+    if(size != plan->systemSize || threads != plan->threadNumber) continue;
+    if(strcmp(kind,"static") == 0) schedule.kind = omp_sched_static;
+    else if(strcmp(kind,"dynamic") == 0) schedule.kind = omp_sched_dynamic;
+    else if(strcmp(kind,"guided") == 0) schedule.kind = omp_sched_guided;
+    else continue;
+    schedule.chunk = chunk;
+    if(strcmp(solver,"row") == 0) { plan->rowSchedule = schedule; found |= 1; }
+    else if(strcmp(solver,"col") == 0) { plan->colSchedule = schedule; found |= 2; }
+  }
+  fclose(cache);
+  return found == 3;
+}
+/**/
+int bs_plan_save_schedules(const bs_plan* plan, const char* fileName)
+{
+  FILE* cache;
+  /**/
+  cache = fopen(fileName,"a");
+  if(cache == NULL) return 0;
+  fprintf(cache,"%d %d row %s %d\n",plan->systemSize,plan->threadNumber,bs_schedule_name(plan->rowSchedule.kind),plan->rowSchedule.chunk);
+  fprintf(cache,"%d %d col %s %d\n",plan->systemSize,plan->threadNumber,bs_schedule_name(plan->colSchedule.kind),plan->colSchedule.chunk);
+  fclose(cache);
+  return 1;
+}
+/**/
+int bs_plan_autotune(bs_plan* plan, const double* A, const double* b, int isVerbose)
+{
+  bs_loop_schedule candidates[] =
+  {
+    {omp_sched_static,0},{omp_sched_static,1},{omp_sched_static,16},{omp_sched_static,64},
+    {omp_sched_dynamic,1},{omp_sched_dynamic,16},{omp_sched_dynamic,64},{omp_sched_dynamic,256},
+    {omp_sched_guided,1},{omp_sched_guided,16},{omp_sched_guided,64}
+  };
+  int candidateNumber = sizeof(candidates)/sizeof(candidates[0]);
+  int c, run;
+  double startTime, elapsedTime, rowTime, colTime, bestRowTime, bestColTime;
+  double* x;
+  bs_plan tune;
+  /* the candidates are evaluated with a copy of the plan */
+  tune = *plan;
+  x = (double*) malloc(sizeof(double)*plan->systemSize);
+  if(x == NULL) return 0;
+  bs_first_touch_vector(plan,x);
+  bestRowTime = bestColTime = -1.0;
+  if(isVerbose)
+  {
+    printf("autotuning the schedules (best of %d calibration solves):\n",CALIBRATION_RUNS);
+    printf("schedule\trow-oriented\tcolumn-oriented\n");
+  }
+  for(c=0;c<candidateNumber;++c)
+  {
+    tune.rowSchedule = tune.colSchedule = candidates[c];
+    rowTime = colTime = -1.0;
+    for(run=0;run<CALIBRATION_RUNS;++run)
+    {
+      startTime = omp_get_wtime();
+      bs_solve_row_omp(&tune,A,b,x);
+      elapsedTime = omp_get_wtime() - startTime;
+      if(rowTime < 0.0 || elapsedTime < rowTime) rowTime = elapsedTime;
+      /**/
+      startTime = omp_get_wtime();
+      bs_solve_col_omp(&tune,A,b,x);
+      elapsedTime = omp_get_wtime() - startTime;
+      if(colTime < 0.0 || elapsedTime < colTime) colTime = elapsedTime;
+    }
+    if(isVerbose) printf("%s,%d\t%lf\t%lf\n",bs_schedule_name(candidates[c].kind),candidates[c].chunk,rowTime,colTime);
+    if(bestRowTime < 0.0 || rowTime < bestRowTime) { bestRowTime = rowTime; plan->rowSchedule = candidates[c]; }
+    if(bestColTime < 0.0 || colTime < bestColTime) { bestColTime = colTime; plan->colSchedule = candidates[c]; }
+  }
+  free(x);
+  return 1;
+}
+/**/
+void bs_first_touch_vector(const bs_plan* plan, double* v)
+{
+  int i;
+  int n = plan->systemSize;
+  /**/
+  #pragma omp parallel for num_threads(plan->threadNumber) default(none) private(i) shared(v,n) schedule(static)
+  for(i=0;i<n;++i) v[i] = 0.0;
+}
+/**/
+void bs_solve_row_serial(const bs_plan* plan, const double* A, const double* b, double* x)
+{
+  int i,j;
+  int n = plan->systemSize;
+  double tmp;
+  /**/
+  for(i=n-1;i>=0;--i)
+  {
+    tmp = b[i];
+    for(j=i+1;j<n;++j) tmp -= ELEMENT(plan,A,i,j)*x[j];
+    x[i] = tmp/ELEMENT(plan,A,i,i);
+  }
+}
+/**/
+void bs_solve_row_omp(const bs_plan* plan, const double* A, const double* b, double* x)
+{
+  /*
+    1. The inner loop (with j) can be parallelized.
+    2. The cumulative result of x[j] can be calculated by using the reduction clause
+       => use the temporary value tmp
+    3. The initialization and the final calculation of x[i] is performed by only 1 threads,
+       => we use the "omp single" directive.
+  */
+  int i,j;
+  int n = plan->systemSize;
+  double tmp;
+  bs_loop_schedule previous;
+  /**/
+  previous = use_schedule(plan->rowSchedule);
+  #pragma omp parallel num_threads(plan->threadNumber) default(none) private(i,j) shared(plan,A,b,x,tmp,n)
+  for(i=n-1;i>=0;--i)
+  {
+    /*initiatlization of x[i]*/
+    #pragma omp single
+    tmp = b[i];
+    /*
+      The schedule is the row schedule of the plan,
+      the best one can be found with bs_plan_autotune()
+     */
+    #pragma omp for reduction(+:tmp) schedule(runtime)
+    for(j=i+1;j<n;++j) tmp -= ELEMENT(plan,A,i,j)*x[j];
+    /* final calculation of x[i] */
+    #pragma omp single
+    x[i] = tmp/ELEMENT(plan,A,i,i);
+  }
+  use_schedule(previous);
+}
+/**/
+void bs_solve_col_serial(const bs_plan* plan, const double* A, const double* b, double* x)
+{
+  int i,j;
+  int n = plan->systemSize;
+  /**/
+  for(i=0;i<n;++i) x[i] = b[i];
+  /**/
+  for(j=n-1;j>=0;--j)
+  {
+    x[j] /= ELEMENT(plan,A,j,j);
+    for(i=0;i<j;++i) x[i] -= ELEMENT(plan,A,i,j)*x[j];
+  }
+}
+/**/
+void bs_solve_col_omp(const bs_plan* plan, const double* A, const double* b, double* x)
+{
+  /*
+    Parallelize the column-oriented backward substitution algorithm
+    1. The "INITIALIZATION LOOP" can be parallelized.
+    2. In the "CALCULATION LOOP":
+      2.1 The inner loop (with i) can be parallelized.
+      2.2 We use the "omp single" directive for the final calculation of x[j]
+  */
+  int i,j;
+  int n = plan->systemSize;
+  bs_loop_schedule previous;
+  /**/
+  previous = use_schedule(plan->colSchedule);
+  #pragma omp parallel num_threads(plan->threadNumber) default(none) private(i,j) shared(plan,A,b,x,n)
+  {
+    /* INITIALIZATION LOOP */
+    #pragma omp for
+    for(i=0;i<n;++i) x[i] = b[i];
+    /**/
+    /* CALCULATION LOOP */
+    for(j=n-1;j>=0;--j)
+    {
+      /*final calculation of x[j]*/
+      #pragma omp single
+      x[j] /= ELEMENT(plan,A,j,j);
+      /*
+	The schedule is the column schedule of the plan,
+	the best one can be found with bs_plan_autotune()
+      */
+      #pragma omp for schedule(runtime)
+      for(i=0;i<j;++i) x[i] -= ELEMENT(plan,A,i,j)*x[j];
+    }
+  }
+  use_schedule(previous);
+}
+/**/
+static void solve_row_float(const bs_plan* plan, const float* A, const float* b, float* x)
+{
+  /*
+    Same as bs_solve_row_omp, in single precision:
+    the traversal of A moves half of the bytes and
+    the vector units process twice more elements.
+  */
+  int i,j;
+  int n = plan->systemSize;
+  float tmp;
+  bs_loop_schedule previous;
+  /**/
+  previous = use_schedule(plan->rowSchedule);
+  #pragma omp parallel num_threads(plan->threadNumber) default(none) private(i,j) shared(A,b,x,tmp,n)
+  for(i=n-1;i>=0;--i)
+  {
+    #pragma omp single
+    tmp = b[i];
+    /**/
+    #pragma omp for simd reduction(+:tmp) schedule(runtime)
+    for(j=i+1;j<n;++j) tmp -= A[(long)i*n+j]*x[j];
+    /**/
+    #pragma omp single
+    x[i] = tmp/A[(long)i*n+i];
+  }
+  use_schedule(previous);
+}
+/**/
+double bs_residual(const bs_plan* plan, const double* A, const double* b, const double* x, double* r)
+{
+  int i,j;
+  int n = plan->systemSize;
+  double tmp;
+  double maxR = 0.0, maxB = 0.0;
+  /* A is upper triangular, only the columns j >= i are used */
+  #pragma omp parallel for num_threads(plan->threadNumber) default(none) private(i,j,tmp) shared(plan,A,b,x,r,n) reduction(max:maxR,maxB) schedule(static)
+  for(i=0;i<n;++i)
+  {
+    tmp = b[i];
+    for(j=i;j<n;++j) tmp -= ELEMENT(plan,A,i,j)*x[j];
+    r[i] = tmp;
+    if(fabs(tmp) > maxR) maxR = fabs(tmp);
+    if(fabs(b[i]) > maxB) maxB = fabs(b[i]);
+  }
+  /**/
+  if(maxB == 0.0) return maxR;
+  return maxR/maxB;
+}
+/**/
+void bs_plan_set_float_matrix(bs_plan* plan, const double* A)
+{
+  int i;
+  int n = plan->systemSize;
+  float* Af = plan->Af;
+  /* the copy of A in float is row-major, written by blocks of rows so it is spread over the memory nodes */
+  #pragma omp parallel for num_threads(plan->threadNumber) default(none) private(i) shared(plan,A,Af,n) schedule(static)
+  for(i=0;i<n;++i)
+  {
+    int j;
+    for(j=0;j<n;++j) Af[(long)i*n+j] = (float) ELEMENT(plan,A,i,j);
+  }
+}
+/**/
+int bs_solve_mixed(bs_plan* plan, const double* A, const double* b, double* x, double tolerance, double* residual)
+{
+  /*
+    1. solve Af xf = b in float
+    2. repeat:
+       r = b - A x in double
+       stop if max|r|/max|b| <= tolerance
+       solve Af d = r in float
+       x = x + d
+    the vectors bf, xf and r are the workspace of the plan
+  */
+  int i, iteration;
+  int n = plan->systemSize;
+  float* bf = plan->bf;
+  float* xf = plan->xf;
+  double* r = plan->r;
+  /**/
+  if(!(plan->flags & BS_PLAN_MIXED_PRECISION))
+  {
+    *residual = -1.0;
+    return -1;
+  }
+  for(i=0;i<n;++i) bf[i] = (float) b[i];
+  solve_row_float(plan,plan->Af,bf,xf);
+  for(i=0;i<n;++i) x[i] = xf[i];
+  /**/
+  iteration = 0;
+  *residual = bs_residual(plan,A,b,x,r);
+  while(*residual > tolerance && iteration < plan->maxRefineIterations)
+  {
+    for(i=0;i<n;++i) bf[i] = (float) r[i];
+    solve_row_float(plan,plan->Af,bf,xf);
+    for(i=0;i<n;++i) x[i] += xf[i];
+    /**/
+    ++iteration;
+    *residual = bs_residual(plan,A,b,x,r);
+  }
+  return iteration;
+}
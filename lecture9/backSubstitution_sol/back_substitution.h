@@ -0,0 +1,113 @@
+/*
+  Backward Substitution step
+  in the Gaussian Elimination
+  for solving upper triangular systems of linear equations:
+  Ax = b
+  ====
+  Reentrant solver library, with a plan/execute split:
+  1. bs_plan_create() stores the system size, the thread number,
+     the storage layout of A and the schedules of the OpenMP loops,
+     and allocates the workspace of the solvers.
+  2. the double precision solvers only read the plan, the mixed precision
+     solver writes its workspace (bf, xf, r), so repeated solves of the same
+     dimension do not allocate anything. Several plans can be used concurrently,
+     with one plan per concurrent mixed precision solve.
+     the solvers set the schedule of their loops with omp_set_schedule and
+     restore the schedule of the calling thread when they return.
+  3. bs_plan_destroy() frees the workspace.
+  ====
+  compile as a library:
+  gcc -c -fPIC -fopenmp -O2 back_substitution.c
+  ar rcs libback_substitution.a back_substitution.o
+  gcc -shared -fopenmp -o libback_substitution.so back_substitution.o
+*/
+#ifndef BACK_SUBSTITUTION_H
+#define BACK_SUBSTITUTION_H
+#include<omp.h>
+/* storage layout of the dense matrix A */
+typedef enum
+{
+  BS_ROW_MAJOR = 0,   /* A(i,j) = A[i*size+j] */
+  BS_COL_MAJOR = 1    /* A(i,j) = A[j*size+i] */
+} bs_layout;
+/* flags of bs_plan_create() */
+#define BS_PLAN_MIXED_PRECISION 1   /* allocate the workspace of the mixed precision solver */
+/*
+   a schedule of the inner loops, used with schedule(runtime),
+   chunk = 0 means the default chunk size of the schedule kind
+*/
+typedef struct
+{
+  omp_sched_t kind;
+  int chunk;
+} bs_loop_schedule;
+/* the plan of the solves of one system dimension */
+typedef struct
+{
+  int systemSize;             /* the number of linear equations in the system */
+  int threadNumber;           /* thread number of the OpenMP solvers */
+  bs_layout layout;           /* storage layout of A */
+  long rowStride;             /* A(i,j) = A[i*rowStride + j*colStride] */
+  long colStride;
+  bs_loop_schedule rowSchedule;  /* schedule of the row-oriented solvers */
+  bs_loop_schedule colSchedule;  /* schedule of the column-oriented solver */
+  int maxRefineIterations;    /* maximum number of iterations of the mixed precision solver */
+  /* workspace */
+  int flags;
+  float* Af;                  /* single precision copy of A (BS_PLAN_MIXED_PRECISION) */
+  float* bf;                  /* single precision right hand side and solution */
+  float* xf;
+  double* r;                  /* residual */
+} bs_plan;
+/*
+   create the plan of the systems of size systemSize,
+   returns NULL if the workspace cannot be allocated
+*/
+bs_plan* bs_plan_create(int systemSize, int threadNumber, bs_layout layout, int flags);
+/* free the plan and its workspace */
+void bs_plan_destroy(bs_plan* plan);
+/* name of a schedule kind, as in OMP_SCHEDULE */
+const char* bs_schedule_name(omp_sched_t kind);
+/*
+   read the schedules for (systemSize, threadNumber) from the cache file,
+   returns 1 if both the row and column schedules were found
+*/
+int bs_plan_load_schedules(bs_plan* plan, const char* fileName);
+/* append the schedules for (systemSize, threadNumber) to the cache file, returns 0 on error */
+int bs_plan_save_schedules(const bs_plan* plan, const char* fileName);
+/*
+   benchmark the candidate schedules on calibration solves of the system A x = b,
+   keep the fastest one for each solver in the plan.
+   if isVerbose, the time of each candidate is printed.
+   returns 0 and keeps the schedules of the plan if the workspace cannot be allocated
+*/
+int bs_plan_autotune(bs_plan* plan, const double* A, const double* b, int isVerbose);
+/* set a vector to 0 in parallel with schedule(static), so its pages are spread over the memory nodes of the threads */
+void bs_first_touch_vector(const bs_plan* plan, double* v);
+/* serial implementation of the row-oriented backward substitution */
+void bs_solve_row_serial(const bs_plan* plan, const double* A, const double* b, double* x);
+/* serial implementation of the column-oriented backward substitution */
+void bs_solve_col_serial(const bs_plan* plan, const double* A, const double* b, double* x);
+/* openmp implementation of the row-oriented backward substitution */
+void bs_solve_row_omp(const bs_plan* plan, const double* A, const double* b, double* x);
+/* openmp implementation of the column-oriented backward substitution */
+void bs_solve_col_omp(const bs_plan* plan, const double* A, const double* b, double* x);
+/*
+   relative residual max|b-Ax|/max|b| in double precision,
+   the residual vector is returned in r
+*/
+double bs_residual(const bs_plan* plan, const double* A, const double* b, const double* x, double* r);
+/*
+   store the single precision copy of A in the workspace of the plan,
+   it is used by all the following mixed precision solves
+*/
+void bs_plan_set_float_matrix(bs_plan* plan, const double* A);
+/*
+   mixed precision: solve in float with the copy of A of the plan,
+   then iterative refinement in double.
+   returns the number of refinement iterations,
+   the final relative residual is returned in residual.
+   the workspace of the plan is overwritten: one plan per concurrent solve
+*/
+int bs_solve_mixed(bs_plan* plan, const double* A, const double* b, double* x, double tolerance, double* residual);
+#endif
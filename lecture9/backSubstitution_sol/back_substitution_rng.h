@@ -0,0 +1,32 @@
+/*
+  reentrant random number generator (xorshift64*) of the input data
+  of omp_back_substitution.c and mpi_back_substitution.c:
+  each row of A has its own state, so the generated matrix
+  does not depend on the number of threads or processes
+*/
+#ifndef BACK_SUBSTITUTION_RNG_H
+#define BACK_SUBSTITUTION_RNG_H
+/* seed the state of the generator of one row */
+static inline unsigned long long rng_seed(unsigned long long seed, int row)
+{
+  /* splitmix64, to get well separated states for consecutive rows */
+  unsigned long long z = seed + 0x9E3779B97F4A7C15ULL*(unsigned long long)(row+1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z = z ^ (z >> 31);
+  /* the state of xorshift must not be 0 */
+  if(z == 0) z = 0x9E3779B97F4A7C15ULL;
+  return z;
+}
+/* next random number of a row */
+static inline unsigned int rng_next(unsigned long long* state)
+{
+  unsigned long long z = *state;
+  /**/
+  z ^= z >> 12;
+  z ^= z << 25;
+  z ^= z >> 27;
+  *state = z;
+  return (unsigned int) ((z * 0x2545F4914F6CDD1DULL) >> 32);
+}
+#endif
@@ -0,0 +1,366 @@
+/*
+  The Backward Substitution step
+  in the Gaussian Elimination
+  for solving systems of linear equations:
+  Ax = b
+  on distributed memory, with MPI.
+  ====
+  The rows of A are distributed in a 1D block-cyclic layout:
+  block K (rows K*blockSize ... (K+1)*blockSize-1) is owned by rank K%numprocs,
+  so no rank stores the whole matrix and the work on the shrinking
+  triangle stays balanced among the ranks.
+  Each rank only stores the upper-right part of its rows
+  (the columns from the first row of the block).
+  ====
+  The blocks of x are solved from the last one to the first one (fan-out/wavefront):
+  1. the owner of block K solves the diagonal block and
+     sends x_K to all the other ranks with non-blocking sends.
+  2. each rank receives the blocks of x with receives posted at the beginning,
+     and subtracts A_iK * x_K from the partial sums of its rows i as soon as x_K arrives.
+  3. the owner of block K-1 first updates the rows of block K-1 with x_K,
+     solves and sends x_(K-1), and only then updates its other rows with x_K
+     (look-ahead), so that the next block of the pipeline is not delayed.
+*/
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<getopt.h>
+#include<math.h>
+#include<time.h>
+#include<mpi.h>
+#include "back_substitution_rng.h"
+/**/
+/*global variables*/
+int systemSize;           /* the number of linear equations in the system */
+int blockSize = 64;       /* number of rows in a block of the block-cyclic distribution, =64 by default */
+int isDisplay = 0;        /* by default, do not display the result, "-d" displays it */
+int myid, numprocs;       /* MPI rank and number of ranks */
+int blockNumber;          /* number of blocks of rows */
+int localBlockNumber;     /* number of blocks of this rank */
+double* localA;           /* the rows of A owned by this rank */
+long* blockOffset;        /* offset of each local block in localA */
+double* localS;           /* partial sums of the owned rows, initialized with b */
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv);
+/* owner rank and local index of the global block K */
+int block_owner(int K);
+int block_local(int K);
+/* first row and number of rows of the global block K */
+int block_start(int K);
+int block_rows(int K);
+/*
+   init input data
+   each rank generates only its own rows,
+   b is the sum of the row as all the elements of x are 1.0
+*/
+void init_local_data(unsigned long long seed);
+/* element (row r of the global block K, column j) of the local part of A */
+double* local_element(int K, int r, int j);
+/* solve the diagonal block K, the rows already contain the updates of the blocks after K */
+void solve_diagonal_block(int K, double* x);
+/* subtract A_iK * x_K from the partial sums of the rows of the local block L */
+void update_block(int L, int K, double* x);
+/* distributed backward substitution, every rank gets the whole vector x */
+void mpi_block_cyclic_back_substitution(double* x);
+/*
+   finding the max error in the result
+   as we know the result vector should contain all 1.0
+ */
+double find_error(double* a);
+/*
+  main function
+  1. To compile:
+  mpicc -o mpi_back_substitution mpi_back_substitution.c -lm
+  2. To run:
+  mpirun -np number_of_processes ./mpi_back_substitution -s system_size [-b block_size] [-d]
+  example: for the system of size 10000, with 4 processes and blocks of 32 rows
+  mpirun -np 4 ./mpi_back_substitution -s 10000 -b 32
+*/
+int main(int argc, char** argv)
+{
+  double* x;
+  unsigned long long seed;
+  double startTime, elapsedTime, maxElapsedTime, diff;
+  int i;
+  /**/
+  MPI_Init(&argc,&argv);
+  MPI_Comm_rank(MPI_COMM_WORLD,&myid);
+  MPI_Comm_size(MPI_COMM_WORLD,&numprocs);
+  /* parse the input arguments from the command line */
+  parseArgs(argc,argv);
+  /**/
+  blockNumber = (systemSize+blockSize-1)/blockSize;
+  localBlockNumber = (blockNumber > myid) ? (blockNumber-myid+numprocs-1)/numprocs : 0;
+  if(myid == 0)
+  {
+    printf("process number = %d\n",numprocs);
+    printf("system size = %d\n",systemSize);
+    printf("block size = %d, %d blocks\n",blockSize,blockNumber);
+    printf("initializing input data:\n");
+  }
+  /* all the ranks use the same seed, so A does not depend on the process number */
+  seed = (unsigned long long) time(NULL);
+  MPI_Bcast(&seed,1,MPI_UNSIGNED_LONG_LONG,0,MPI_COMM_WORLD);
+  init_local_data(seed);
+  x = (double*) malloc(sizeof(double)*systemSize);
+  if(myid == 0)
+  {
+    printf("done\n");
+    printf("====\n");
+    printf("Backward substitution with the MPI block-cyclic algorithm:\n");
+  }
+  /**/
+  MPI_Barrier(MPI_COMM_WORLD);
+  startTime = MPI_Wtime();
+  mpi_block_cyclic_back_substitution(x);
+  elapsedTime = MPI_Wtime() - startTime;
+  MPI_Reduce(&elapsedTime,&maxElapsedTime,1,MPI_DOUBLE,MPI_MAX,0,MPI_COMM_WORLD);
+  /**/
+  if(myid == 0)
+  {
+    printf("Done\n");
+    printf("====\n");
+    if(isDisplay)
+    {
+      printf("result:\n");
+      for(i=0;i<systemSize;++i) printf("%.3lf  ",x[i]);
+      printf("\n");
+    }
+    diff = find_error(x);
+    printf("Max error in the results of the MPI block-cyclic algorithm:\t %e\n",diff);
+    printf("====\n");
+    printf("Running time:\n");
+    printf("MPI, block-cyclic\t: %lf (s)\n",maxElapsedTime);
+  }
+  /* free allocated memory */
+  free(localA);
+  free(localS);
+  free(blockOffset);
+  free(x);
+  /**/
+  MPI_Finalize();
+  return 0;
+}
+/**/
+void mpi_block_cyclic_back_substitution(double* x)
+{
+  int K, L;
+  int requestNumber;
+  int lookAhead;
+  MPI_Request* recvRequest;
+  MPI_Request* sendRequest;
+  /*
+     post the receives of all the blocks of x owned by the other ranks,
+     in the same order as they are sent (from the last block to the first one)
+  */
+  recvRequest = (MPI_Request*) malloc(sizeof(MPI_Request)*(blockNumber+1));
+  for(K=blockNumber-1;K>=0;--K)
+  {
+    recvRequest[K] = MPI_REQUEST_NULL;
+    if(block_owner(K) != myid)
+      MPI_Irecv(x+block_start(K),block_rows(K),MPI_DOUBLE,block_owner(K),0,MPI_COMM_WORLD,&recvRequest[K]);
+  }
+  sendRequest = (MPI_Request*) malloc(sizeof(MPI_Request)*(localBlockNumber*(numprocs-1)+1));
+  requestNumber = 0;
+  /* the last block does not need any update */
+  if(block_owner(blockNumber-1) == myid)
+  {
+    solve_diagonal_block(blockNumber-1,x);
+    for(L=0;L<numprocs;++L) if(L != myid)
+      MPI_Isend(x+block_start(blockNumber-1),block_rows(blockNumber-1),MPI_DOUBLE,L,0,MPI_COMM_WORLD,&sendRequest[requestNumber++]);
+  }
+  /**/
+  for(K=blockNumber-1;K>=0;--K)
+  {
+    /* wait for x_K, the partial updates of the previous blocks are already done */
+    MPI_Wait(&recvRequest[K],MPI_STATUS_IGNORE);
+    /* look-ahead: the next block in the pipeline is updated, solved and sent first */
+    lookAhead = (K > 0 && block_owner(K-1) == myid);
+    if(lookAhead)
+    {
+      update_block(block_local(K-1),K,x);
+      solve_diagonal_block(K-1,x);
+      for(L=0;L<numprocs;++L) if(L != myid)
+	MPI_Isend(x+block_start(K-1),block_rows(K-1),MPI_DOUBLE,L,0,MPI_COMM_WORLD,&sendRequest[requestNumber++]);
+    }
+    /* update all the other local rows above block K with x_K */
+    for(L=0;L<localBlockNumber;++L)
+    {
+      if(L*numprocs+myid >= K) break;
+      if(lookAhead && L == block_local(K-1)) continue;
+      update_block(L,K,x);
+    }
+  }
+  /**/
+  MPI_Waitall(requestNumber,sendRequest,MPI_STATUSES_IGNORE);
+  free(sendRequest);
+  free(recvRequest);
+}
+/**/
+void solve_diagonal_block(int K, double* x)
+{
+  int r, j;
+  int start = block_start(K);
+  int rows = block_rows(K);
+  double* s = localS + (long) block_local(K)*blockSize;
+  double tmp;
+  /**/
+  for(r=rows-1;r>=0;--r)
+  {
+    tmp = s[r];
+    for(j=start+r+1;j<start+rows;++j) tmp -= *local_element(K,r,j)*x[j];
+    x[start+r] = tmp / *local_element(K,r,start+r);
+  }
+}
+/**/
+void update_block(int L, int K, double* x)
+{
+  int r, j;
+  int G = L*numprocs + myid;     /* global index of the local block L */
+  int start = block_start(K);
+  int end = start + block_rows(K);
+  double* s = localS + (long) L*blockSize;
+  double* row;
+  double tmp;
+  /**/
+  for(r=0;r<block_rows(G);++r)
+  {
+    row = local_element(G,r,start);
+    tmp = 0.0;
+    for(j=0;j<end-start;++j) tmp += row[j]*x[start+j];
+    s[r] -= tmp;
+  }
+}
+/**/
+/* init input data*/
+void init_local_data(unsigned long long seed)
+{
+  int L, K, r, i, j;
+  int rand1, rand2;
+  unsigned long long state;
+  long size;
+  /* the local rows of block K store the columns K*blockSize ... systemSize-1 */
+  blockOffset = (long*) malloc(sizeof(long)*(localBlockNumber+1));
+  size = 0;
+  for(L=0;L<localBlockNumber;++L)
+  {
+    K = L*numprocs + myid;
+    blockOffset[L] = size;
+    size += (long) block_rows(K)*(systemSize-block_start(K));
+  }
+  blockOffset[localBlockNumber] = size;
+  localA = (double*) malloc(sizeof(double)*(size+1));
+  localS = (double*) malloc(sizeof(double)*((long) localBlockNumber*blockSize+1));
+  /**/
+  for(L=0;L<localBlockNumber;++L)
+  {
+    K = L*numprocs + myid;
+    for(r=0;r<block_rows(K);++r)
+    {
+      i = block_start(K) + r;
+      state = rng_seed(seed,i);
+      for(j=block_start(K);j<i;++j) *local_element(K,r,j) = 0.0;
+      *local_element(K,r,i) = systemSize/10.0;
+      localS[(long) L*blockSize+r] = *local_element(K,r,i);
+      for(j=i+1;j<systemSize;++j)
+      {
+	rand1 = rng_next(&state)%100;
+	rand2 = rng_next(&state)%10;
+	if(rand1 == 0) rand1 = 1;
+	if(rand2 == 0) rand2 = 1;
+	/**/
+	*local_element(K,r,j) = (double) rand1/rand2;
+	localS[(long) L*blockSize+r] += *local_element(K,r,j);
+      }
+    }
+  }
+}
+/**/
+double* local_element(int K, int r, int j)
+{
+  int start = block_start(K);
+  return localA + blockOffset[block_local(K)] + (long) r*(systemSize-start) + (j-start);
+}
+/**/
+int block_owner(int K)
+{
+  return K%numprocs;
+}
+/**/
+int block_local(int K)
+{
+  return K/numprocs;
+}
+/**/
+int block_start(int K)
+{
+  return K*blockSize;
+}
+/**/
+int block_rows(int K)
+{
+  if((K+1)*blockSize > systemSize) return systemSize - K*blockSize;
+  return blockSize;
+}
+/*
+   finding the max error in the result
+   as we know the result vector should contain all 1.0
+ */
+double find_error(double* a)
+{
+  int i;
+  double returnDiff = 0.0;
+  double diff;
+  /**/
+  for(i=0;i<systemSize;++i)
+  {
+    diff = fabs(a[i]-1.0);
+    if(diff > returnDiff) returnDiff = diff;
+  }
+  /**/
+  return returnDiff;
+}
+/* To parse the input arguments of the application */
+void parseArgs(int argc, char** argv)
+{
+  int c;
+  int optionIndex = 0;
+  struct option longOption[]=
+  {
+    {"system-size",1,NULL,'s'},
+    {"block-size",1,NULL,'b'},
+    {"is-display",0,NULL,'d'},
+    {0,0,0,0}
+  };
+  if (argc < 3)
+  {
+    if(myid == 0) printf("Wrong number of arguments\n");
+    MPI_Finalize();
+    exit(1);
+  }
+  while((c=getopt_long(argc,argv,"s:b:d",longOption,&optionIndex))!=-1)
+  {
+    switch(c)
+    {
+      case 's':
+	systemSize = atoi(optarg);
+	break;
+      case 'b':
+	blockSize = atoi(optarg);
+	break;
+      case 'd':
+	isDisplay = 1;
+	break;
+      default:
+	if(myid == 0) printf("Bad argument %c\n",c);
+	MPI_Finalize();
+	exit(1);
+    }
+  }
+  if(systemSize <= 0 || blockSize <= 0)
+  {
+    if(myid == 0) printf("The system size and the block size must be positive\n");
+    MPI_Finalize();
+    exit(1);
+  }
+}
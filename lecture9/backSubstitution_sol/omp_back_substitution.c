@@ -6,9 +6,18 @@
   with OpenMP, 
   using the row-oriented algorthm 
   and column-oriented algorithm.
+  The solvers are in the library back_substitution.c (see back_substitution.h),
+  this program generates the input, runs and compares them.
   ====
-  
+  The input data is generated in parallel, so the n^2 random values
+  do not take longer than the solves, and the pages of A are spread
+  over the memory nodes of the threads ("first touch") instead of all
+  being placed on the node of the master thread. This placement does not
+  follow the partition of the solvers: they split the columns of a row
+  (row-oriented) or the rows above the diagonal element (column-oriented),
+  with the schedule of the plan, so each thread reads from all the nodes.
 */
+#define _GNU_SOURCE
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
@@ -16,6 +25,10 @@
 #include <getopt.h>
 #include <math.h>
 #include<time.h>
+#include<sched.h>
+#include<unistd.h>
+#include "back_substitution.h"
+#include "back_substitution_rng.h"
 /**/
 /*global variables*/
 int systemSize;           /* the number of linear equations in the system */
@@ -29,8 +42,26 @@ int isDisplay = 0;      /* by default,
 			   input argument of the program to display 
 			   both the input data and the results.
 			*/
+int isPinned = 0;       /* by default, threads are not pinned by the application.
+			   Adding "-p" pins thread t to the t-th cpu
+			   of the process affinity mask.
+			   (OMP_PROC_BIND/OMP_PLACES can be used instead)
+			*/
+double refineTolerance = 0.0; /* by default, the mixed precision solver is not run.
+			   Adding "-r tolerance" solves the system in float and
+			   refines the result in double, until the relative residual
+			   max|b-Ax|/max|b| is below the tolerance.
+			*/
+int isAutotune = 0;     /* by default, the schedule of the OpenMP solvers is read
+			   from the cache file (static if there is no entry).
+			   Adding "-a" benchmarks the candidate schedules on a 
+			   calibration solve and stores the winners in the cache file.
+			*/
+char* scheduleCacheName = "omp_back_substitution.cache"; /* "-c file" changes the cache file */
 /* To parse the input arguments of the application */
 void parseArgs(int argc, char** argv);
+/* pin the OpenMP threads (-p) and report their binding */
+void bind_threads();
 /* 
    init input data
    randomly generate the upper-right triangle of the matrix A
@@ -38,6 +69,9 @@ void parseArgs(int argc, char** argv);
    calculate the element in the vector b
    => the results after solving this equations should be 
    a vector which contains all 1.0
+   The rows are generated in parallel with schedule(static):
+   each block of rows is first touched (and placed) on the 
+   NUMA node of the thread that generates it.
  */
 void init_input_data();
 /* display input data: matrix A and vector b*/
@@ -49,21 +83,14 @@ void display_result(double* x_row_serial, double* x_row_omp, double* x_col_seria
    as we know the result vector should contain all 1.0
  */
 double find_error(double* a);
-/* serial implementation of the row-oriented backward substitution */
-void serial_row_oriented_back_substitution(double* A,double* b, double* x);
-/* serial implementation of the column-oriented backward substitution */
-void serial_col_oriented_back_substitution(double* A,double* b, double* x);
-/* openmp implementation of the row-oriented backward substitution */
-void omp_row_oriented_back_substitution(double* A,double* b, double* x);
-/* openmp implementation of the column-oriented backward substitution */
-void omp_col_oriented_back_substitution(double* A,double* b, double* x);
 /*
   main function
   1. To compile:
-  gcc -o omp_back_substitution omp_back_substitution.c -fopenmp -lm
+  gcc -o omp_back_substitution omp_back_substitution.c back_substitution.c -fopenmp -lm
+  or with the library: make
   2. To run:
-  ./omp_back_substitution  -s system_size -n thread_number [-d] 
-  -d is an optinal arguments
+  ./omp_back_substitution  -s system_size -n thread_number [-d] [-p] [-r tolerance] [-a] [-c cache_file]
+  -d, -p, -r, -a, -c are optinal arguments
   example: for the system of size 10000 with 4 threads
   ./omp_back_substitution -s 10000 -n 4
   ./omp_back_substitution -s 10000 -n 8 -d
@@ -76,45 +103,71 @@ int main(int argc, char** argv)
   double startTimeOmp1, endTimeOmp1, elapsedTimeOmp1;
   double startTimeOmp2, endTimeOmp2, elapsedTimeOmp2;
   double diff1, diff2;
+  double* x_mixed;
+  double startTimeMixed, elapsedTimeConvert, elapsedTimeMixed, residual, diff3;
+  int iterations;
+  bs_plan* plan;
   /* parse the input arguments from the command line */
   parseArgs(argc,argv);
   /**/
   printf("thread number = %d\n",threadNumber);
   printf("system size = %d\n",systemSize);
   /**/
+  bind_threads();
+  /**/
   init_input_data();
   /**/
   if(isDisplay) display_input_data();
+  /* plan of the solves: dimension, threads, layout of A and workspace */
+  plan = bs_plan_create(systemSize,threadNumber,BS_ROW_MAJOR,(refineTolerance > 0.0) ? BS_PLAN_MIXED_PRECISION : 0);
+  if(plan == NULL)
+  {
+    printf("Error allocating the solver workspace\n");
+    exit(1);
+  }
+  /* schedule of the OpenMP solvers */
+  if(isAutotune)
+  {
+    if(!bs_plan_autotune(plan,A,b,1)) printf("Error allocating the autotuning workspace, the default schedules are kept\n");
+    else if(bs_plan_save_schedules(plan,scheduleCacheName)) printf("schedules saved in %s\n",scheduleCacheName);
+    else printf("Error writing the schedule cache %s\n",scheduleCacheName);
+  }
+  else if(bs_plan_load_schedules(plan,scheduleCacheName)) printf("schedules read from %s\n",scheduleCacheName);
+  printf("row-oriented schedule: %s,%d\n",bs_schedule_name(plan->rowSchedule.kind),plan->rowSchedule.chunk);
+  printf("column-oriented schedule: %s,%d\n",bs_schedule_name(plan->colSchedule.kind),plan->colSchedule.chunk);
+  printf("====\n");
   /* allocate the result vectors */
   x_row_serial = (double*) malloc(sizeof(double)*systemSize);
   x_col_serial = (double*) malloc(sizeof(double)*systemSize);
   x_row_omp = (double*) malloc(sizeof(double)*systemSize);
   x_col_omp = (double*) malloc(sizeof(double)*systemSize);
+  bs_first_touch_vector(plan,x_row_omp);
+  bs_first_touch_vector(plan,x_col_omp);
   /* row oriented method, serial */
   printf("Backward substitution with the serial row-oriented algorithm:\n");
   startTimeSerial1 = omp_get_wtime();
-  serial_row_oriented_back_substitution(A,b,x_row_serial);
+  bs_solve_row_serial(plan,A,b,x_row_serial);
   endTimeSerial1 = omp_get_wtime();
   elapsedTimeSerial1 = endTimeSerial1 - startTimeSerial1;
   printf("Done\n");
   /* row oriented method, OpenMP */
   printf("Backward substitution with the OpenMP row-oriented algorithm:\n");
   startTimeOmp1 = omp_get_wtime();
-  omp_row_oriented_back_substitution(A,b,x_row_omp);
+  bs_solve_row_omp(plan,A,b,x_row_omp);
   endTimeOmp1 = omp_get_wtime();
   elapsedTimeOmp1 = endTimeOmp1 - startTimeOmp1;
   printf("Done\n");
   /* column-oriented method, serial */
   printf("Backward substitution with the serial column-oriented algorithm:\n");
   startTimeSerial2 = omp_get_wtime();
-  serial_col_oriented_back_substitution(A,b,x_col_serial);
+  bs_solve_col_serial(plan,A,b,x_col_serial);
   endTimeSerial2 = omp_get_wtime();
   elapsedTimeSerial2 = endTimeSerial2 - startTimeSerial2;
   printf("Done\n");
   /* column oriented method, OpenMP */
   printf("Backward substitution with the OpenMP column-oriented algorithm:\n");
   startTimeOmp2 = omp_get_wtime();
-  omp_col_oriented_back_substitution(A,b,x_col_omp);
+  bs_solve_col_omp(plan,A,b,x_col_omp);
   endTimeOmp2 = omp_get_wtime();
   elapsedTimeOmp2 = endTimeOmp2 - startTimeOmp2;
   printf("Done\n");
@@ -134,7 +187,37 @@ int main(int argc, char** argv)
   printf("OpenMP, row-oriented\t: %lf (s), speed-up = %lf\n",elapsedTimeOmp1,elapsedTimeSerial1/elapsedTimeOmp1);
   printf("Serial, column-oriented\t: %lf (s)\n",elapsedTimeSerial2);
   printf("OpenMP, column-oriented\t: %lf (s), speed-up = %lf\n",elapsedTimeOmp2,elapsedTimeSerial2/elapsedTimeOmp2);
+  /* mixed precision with iterative refinement */
+  if(refineTolerance > 0.0)
+  {
+    printf("====\n");
+    printf("Backward substitution in float with iterative refinement in double, tolerance = %e:\n",refineTolerance);
+    x_mixed = (double*) malloc(sizeof(double)*systemSize);
+    bs_first_touch_vector(plan,x_mixed);
+    /* the single precision copy of A is kept in the plan */
+    startTimeMixed = omp_get_wtime();
+    bs_plan_set_float_matrix(plan,A);
+    elapsedTimeConvert = omp_get_wtime() - startTimeMixed;
+    /**/
+    startTimeMixed = omp_get_wtime();
+    iterations = bs_solve_mixed(plan,A,b,x_mixed,refineTolerance,&residual);
+    elapsedTimeMixed = omp_get_wtime() - startTimeMixed;
+    /**/
+    diff3 = find_error(x_mixed);
+    if(residual > refineTolerance) printf("not converged after %d iterations\n",iterations);
+    else printf("Done\n");
+    printf("Refinement iterations\t: %d\n",iterations);
+    printf("Relative residual\t: %e\n",residual);
+    printf("Max error in the results of the mixed precision algorithm:\t %e\n",diff3);
+    /* against the OpenMP row-oriented solve in double on the same threads: the gain of the precision only */
+    printf("Mixed precision, row-oriented\t: %lf (s), speed-up over OpenMP double = %lf, over serial = %lf\n",
+           elapsedTimeMixed,elapsedTimeOmp1/elapsedTimeMixed,elapsedTimeSerial1/elapsedTimeMixed);
+    printf("Conversion of A to float\t: %lf (s)\n",elapsedTimeConvert);
+    /**/
+    free(x_mixed);
+  }
   /* free allocated memory */
+  bs_plan_destroy(plan);
   free(A);
   free(b);
   free(x_row_serial);
@@ -145,134 +228,107 @@ int main(int argc, char** argv)
   return 0;
 }
 /**/
-void serial_row_oriented_back_substitution(double* A,double* b, double* x)
-{
-  int i,j;
-  double tmp;
-  /**/
-  for(i=systemSize-1;i>=0;--i)
-  {
-    tmp = b[i];
-    for(j=i+1;j<systemSize;++j) tmp -= A[i*systemSize+j]*x[j];
-    x[i] = tmp/A[i*systemSize+i];
-  }
-}
-/**/
-void omp_row_oriented_back_substitution(double* A,double* b, double* x)
-{
-  /*
-    1. The inner loop (with j) can be parallelized.
-    2. The cumulative result of x[j] can be calculated by using the reduction clause
-       => use the temporary value tmp
-    3. The initialization and the final calculation of x[i] is performed by only 1 threads, 
-       => we use the "omp single" directive.
-  */
-  int i,j;
-  double tmp;
-  /**/
-  #pragma omp parallel num_threads(threadNumber) default(none) private(i,j) shared(A,b,x,tmp,systemSize)
-  for(i=systemSize-1;i>=0;--i)
-  {
-    /*initiatlization of x[i]*/ 
-    #pragma omp single
-    tmp = b[i];
-    /*
-      Notice: you can specify different types of scheduling here
-      to evaluate the performance
-     */
-    #pragma omp for reduction(+:tmp) schedule(static)
-    for(j=i+1;j<systemSize;++j) tmp -= A[i*systemSize+j]*x[j];
-    /* final calculation of x[i] */
-    #pragma omp single 
-    x[i] = tmp/A[i*systemSize+i];
-  }
-}
-/**/
-void serial_col_oriented_back_substitution(double* A,double* b, double* x)
-{
-  int i,j;
-  /**/
-  for(i=0;i<systemSize;++i) x[i] = b[i];
-  /**/
-  for(j=systemSize-1;j>=0;--j) 
-  {
-    x[j] /= A[j*systemSize+j];
-    for(i=0;i<j;++i) x[i] -= A[i*systemSize+j]*x[j];
-  }
-}
-/**/
-void omp_col_oriented_back_substitution(double* A,double* b, double* x)
-{
-  /*
-    Parallelize the column-oriented backward substitution algorithm
-    1. The "INITIALIZATION LOOP" can be parallelized.
-    2. In the "CALCULATION LOOP":
-      2.1 The inner loop (with i) can be parallelized.
-      2.2 We use the "omp single" directive for the final calculation of x[j] 
-  */
-  int i,j;
-  /**/
-  #pragma omp parallel num_threads(threadNumber) default(none) private(i,j) shared(A,b,x,systemSize)
-  {
-    /* INITIALIZATION LOOP */
-    #pragma omp for
-    for(i=0;i<systemSize;++i) x[i] = b[i];
-    /**/
-    /* CALCULATION LOOP */
-    for(j=systemSize-1;j>=0;--j) 
-    {
-      /*final calculation of x[j]*/ 
-      #pragma omp single 
-      x[j] /= A[j*systemSize+j];
-      /*
-	Notice: you can specify different types of scheduling here
-	to evaluate the performance
-      */
-      #pragma omp for schedule(static)
-      for(i=0;i<j;++i) x[i] -= A[i*systemSize+j]*x[j];
-    }
-  }
-}
-/**/
 /* init input data*/
 void init_input_data()
 {
   int i,j;
   int rand1, rand2;
-  double* tmpX;
+  unsigned long long seed, state;
+  double tmp;
   /**/
-  srand(time(NULL));
+  seed = (unsigned long long) time(NULL);
   /**/
   A = (double*) malloc(sizeof(double)*systemSize*systemSize);
   b = (double*) malloc(sizeof(double)*systemSize);
-  tmpX = (double*) malloc(sizeof(double)*systemSize);
   /**/
   printf("initializing input data:\n");
+  /*
+    malloc() only reserves the pages, they are placed on a NUMA node
+    when they are written the first time. The blocks of rows are written here
+    by all the threads, so A is spread over their memory nodes.
+    The generator is reentrant, with one state per row.
+    As all the elements in the vector X are 1.0, b[i] is the sum of the row.
+  */
+  #pragma omp parallel for num_threads(threadNumber) default(none) private(i,j,rand1,rand2,state,tmp) shared(A,b,seed,systemSize) schedule(static)
   for(i=0;i<systemSize;++i)
   {
+    state = rng_seed(seed,i);
     for(j=0;j<i;++j) A[i*systemSize+j] = 0.0;
     A[i*systemSize+i] = systemSize/10.0;
+    tmp = A[i*systemSize+i];
     for(j=i+1;j<systemSize;++j)
     { 
-      rand1 = rand()%100;
-      rand2 = rand()%10;
+      rand1 = rng_next(&state)%100;
+      rand2 = rng_next(&state)%10;
       if(rand1 == 0) rand1 = 1;
       if(rand2 == 0) rand2 = 1;
       /**/
       A[i*systemSize+j] = (double) rand1/rand2;
+      tmp += A[i*systemSize+j];
     }
+    b[i] = tmp;
   }
+  printf("done\n");
+  printf("====\n");
+}
+/**/
+void bind_threads()
+{
+  int i;
+  int cpuNumber;
+  int cpus[CPU_SETSIZE];
+  cpu_set_t processMask;
+  const char* bindNames[] = {"false","true","master","close","spread"};
+  omp_proc_bind_t bind;
+  /* the cpus this process is allowed to run on */
+  cpuNumber = 0;
+  sched_getaffinity(0,sizeof(cpu_set_t),&processMask);
+  for(i=0;i<CPU_SETSIZE;++i) if(CPU_ISSET(i,&processMask)) cpus[cpuNumber++] = i;
   /**/
-  for(i=0;i<systemSize;++i) tmpX[i] = 1.0;
-  /**/
-  for(i=0;i<systemSize;++i)
+  bind = omp_get_proc_bind();
+  printf("OMP_PROC_BIND = %s, OMP_PLACES: %d places\n",
+         (bind >= 0 && bind <= 4) ? bindNames[bind] : "unknown",omp_get_num_places());
+  if(isPinned && bind != omp_proc_bind_false)
   {
-    b[i] = 0.0;
-    for(j=0;j<systemSize;++j) b[i] += A[i*systemSize+j]*tmpX[j];
+    printf("threads are bound by the OpenMP runtime, -p is ignored\n");
+    isPinned = 0;
+  }
+  /*
+    The OpenMP runtime keeps its threads between parallel regions 
+    with the same number of threads, so the binding done here
+    holds for the initialization and for the solvers.
+  */
+  #pragma omp parallel num_threads(threadNumber) default(none) private(i) shared(isPinned,cpus,cpuNumber,threadNumber)
+  {
+    int id = omp_get_thread_num();
+    int cpu, count;
+    char list[256];
+    int length = 0;
+    cpu_set_t mask;
+    /**/
+    if(isPinned)
+    {
+      CPU_ZERO(&mask);
+      CPU_SET(cpus[id%cpuNumber],&mask);
+      sched_setaffinity(0,sizeof(cpu_set_t),&mask);
+    }
+    /* report the affinity mask of each thread */
+    sched_getaffinity(0,sizeof(cpu_set_t),&mask);
+    count = 0;
+    list[0] = '\0';
+    for(cpu=0;cpu<CPU_SETSIZE && length < (int) sizeof(list)-16;++cpu)
+    {
+      if(!CPU_ISSET(cpu,&mask)) continue;
+      length += sprintf(list+length,count ? ",%d" : "%d",cpu);
+      ++count;
+    }
+    #pragma omp for ordered schedule(static,1)
+    for(i=0;i<threadNumber;++i)
+    {
+      #pragma omp ordered
+      printf("thread %d: running on cpu %d, affinity mask = {%s}\n",id,sched_getcpu(),list);
+    }
   }
-  printf("done\n");
-  printf("====\n");
-  free(tmpX);
 }
 /**/
 void display_input_data()
@@ -324,7 +380,7 @@ double find_error(double* a)
   /**/
   for(i=0;i<systemSize;++i)
   { 
-    diff = abs(a[i]-1.0);
+    diff = fabs(a[i]-1.0);
     if(diff > returnDiff) returnDiff = diff;
   }
   /**/
@@ -340,6 +396,10 @@ void parseArgs(int argc, char** argv)
     {"system-size",1,NULL,'s'},
     {"is-display",1,NULL,'d'},
     {"thread-number",1,NULL,'n'},
+    {"pin-threads",0,NULL,'p'},
+    {"refine-tolerance",1,NULL,'r'},
+    {"autotune",0,NULL,'a'},
+    {"cache-file",1,NULL,'c'},
     {0,0,0,0}
   };
   if (argc < 5) 
@@ -347,7 +407,7 @@ void parseArgs(int argc, char** argv)
     printf("Wrong number of arguments\n");
     exit(1);
   }
-  while((c=getopt_long(argc,argv,"n:s:d",longOption,&optionIndex))!=-1)
+  while((c=getopt_long(argc,argv,"n:s:dpr:ac:",longOption,&optionIndex))!=-1)
   {
     switch(c)
     {
@@ -360,6 +420,18 @@ void parseArgs(int argc, char** argv)
       case 'n':
 	threadNumber = atoi(optarg);
 	break;
+      case 'p':
+	isPinned = 1;
+	break;
+      case 'r':
+	refineTolerance = atof(optarg);
+	break;
+      case 'a':
+	isAutotune = 1;
+	break;
+      case 'c':
+	scheduleCacheName = optarg;
+	break;
       default:
 	printf("Bad argument %c\n",c);
 	exit(1);